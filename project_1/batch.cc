@@ -0,0 +1,130 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Batch mode: many programs per process.
+ */
+#include "./batch.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "./inputbuf.h"
+#include "./pool.h"
+
+static bool batch_mode = false;
+
+void Exit(int status) {
+  if (batch_mode) throw ProgramExit{status};
+  exit(status);
+}
+
+static const char* SkipSpace(const char* p, const char* end) {
+  while (p < end && isspace(static_cast<unsigned char>(*p))) p++;
+  return p;
+}
+
+// True if [line, eol) is a delimiter line, ignoring surrounding white space
+static bool IsDelimiter(const char* line, const char* eol) {
+  line = SkipSpace(line, eol);
+  while (eol > line && isspace(static_cast<unsigned char>(eol[-1]))) eol--;
+  size_t length = strlen(BATCH_DELIMITER);
+  return static_cast<size_t>(eol - line) == length &&
+         memcmp(line, BATCH_DELIMITER, length) == 0;
+}
+
+struct Program {
+  const char* begin;
+  const char* end;
+};
+
+// Splits [p, end) at the delimiter lines
+static std::vector<Program> Split(const char* p, const char* end) {
+  std::vector<Program> programs;
+  while (p < end) {
+    const char* program_end = end;
+    const char* next = end;
+    for (const char* line = p; line < end; line = next) {
+      const char* eol =
+          static_cast<const char*>(memchr(line, '\n', end - line));
+      next = eol == NULL ? end : eol + 1;
+      if (IsDelimiter(line, eol == NULL ? end : eol)) {
+        program_end = line;
+        break;
+      }
+    }
+
+    // white space after the last delimiter
+    if (program_end == end && SkipSpace(p, end) == end) break;
+
+    Program program = {p, program_end};
+    programs.push_back(program);
+    p = next;
+  }
+  return programs;
+}
+
+// Runs one program on the calling thread and returns its exit status
+static int RunProgram(void (*run)(std::ostream&), const Program& program,
+                      std::ostream& out) {
+  int status = 0;
+  InputBuffer::SetSource(program.begin, program.end - program.begin);
+  try {
+    run(out);
+  } catch (const ProgramExit& e) {
+    status = e.status;
+  } catch (const std::exception& e) {
+    out << "Error: " << e.what() << "\n";
+    status = 1;
+  }
+  InputBuffer::SetSource(NULL, 0);
+  return status;
+}
+
+static void Report(int program, int status) {
+  std::cout << "\n" << BATCH_DELIMITER << " program " << program;
+  if (status == 0) {
+    std::cout << ": ok" << std::endl;
+  } else {
+    std::cout << ": error " << status << std::endl;
+  }
+}
+
+int RunBatch(void (*run)(std::ostream&), int jobs) {
+  InputBuffer all;
+  std::vector<Program> programs = Split(all.Position(), all.End());
+  int n = static_cast<int>(programs.size());
+  std::vector<int> status(n, 0);
+
+  batch_mode = true;
+  if (jobs == 1) {
+    for (int i = 0; i < n; i++) {
+      status[i] = RunProgram(run, programs[i], std::cout);
+      Report(i + 1, status[i]);
+    }
+  } else {
+    std::vector<std::ostringstream> output(n);
+    ThreadPool pool(jobs);
+    for (int i = 0; i < n; i++) {
+      pool.Submit([&, i] {
+        status[i] = RunProgram(run, programs[i], output[i]);
+      });
+    }
+    pool.Wait();
+    for (int i = 0; i < n; i++) {
+      std::cout << output[i].str();
+      Report(i + 1, status[i]);
+    }
+  }
+  batch_mode = false;
+
+  int errors = 0;
+  for (int i = 0; i < n; i++) {
+    if (status[i] != 0) errors++;
+  }
+  return errors;
+}
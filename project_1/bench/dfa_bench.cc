@@ -0,0 +1,161 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Token DFA matcher benchmark. For every state count given on the command
+ * line a random DFA over 36 byte classes is generated and compressed, and a
+ * batch of words is generated by walking it, so that the walks visit states
+ * all over the tables. The words are then tokenized with one Match() call
+ * after another and with DfaView::Tokenize() at several lane counts.
+ *
+ * Build and run from project_1 with
+ *
+ *     sh bench/run_dfa.sh [STATES ...]
+ *
+ * The default state counts give tables of about 40 KB, 4 MB and 12 MB, so
+ * the largest ones miss in L1 and L2 on every transition.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../dfa.h"
+
+#define CLASSES 36
+#define WORDS 2000000
+
+// ------- input generator -------------------
+
+static uint64_t seed = 340;
+
+static int Random(int n) {
+  seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return static_cast<int>((seed >> 33) % n);
+}
+
+static const char chars[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+
+// Every state has a few live classes leading anywhere, and about a third of
+// the states accept one of 50 tokens
+static Dfa RandomDfa(int states) {
+  Dfa dfa;
+  dfa.classes = CLASSES + 1;
+  memset(dfa.byte_class, 0, sizeof(dfa.byte_class));
+  for (int c = 0; c < CLASSES; c++) {
+    dfa.byte_class[static_cast<unsigned char>(chars[c])] = c + 1;
+  }
+  dfa.next.assign(static_cast<size_t>(states) * dfa.classes, DFA_DEAD);
+  for (int s = 0; s < states; s++) {
+    dfa.token.push_back(Random(3) == 0 ? Random(50) : -1);
+    int live = 2 + Random(6);
+    for (int i = 0; i < live; i++) {
+      dfa.next[s * dfa.classes + 1 + Random(CLASSES)] = Random(states);
+    }
+  }
+  return dfa;
+}
+
+// Words of 4 to 24 characters along live transitions from the start state,
+// so every word is walked to its end before its first token is known
+static std::vector<std::string> Words(const Dfa& dfa) {
+  std::vector<std::string> words;
+  for (int i = 0; i < WORDS; i++) {
+    std::string word;
+    int state = 0;
+    int length = 4 + Random(21);
+    while (static_cast<int>(word.size()) < length) {
+      int c = 1 + Random(CLASSES);
+      int next = dfa.next[state * dfa.classes + c];
+      if (next != DFA_DEAD) {
+        word += chars[c - 1];
+        state = next;
+      }
+    }
+    words.push_back(word);
+  }
+  return words;
+}
+
+// ------- timing -------------------
+
+static double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+static void Report(const char* what, int64_t bytes, size_t tokens,
+                   double seconds, double base) {
+  printf("  %-22s %8.3f s %9.1f MB/s %8zu tokens  %5.2fx\n", what, seconds,
+         bytes / seconds / (1024.0 * 1024.0), tokens, base / seconds);
+}
+
+int main(int argc, char* argv[]) {
+  std::vector<int> sizes;
+  for (int i = 1; i < argc; i++) {
+    if (atoi(argv[i]) < 1) {
+      printf("usage: %s [STATES ...]\n", argv[0]);
+      return 1;
+    }
+    sizes.push_back(atoi(argv[i]));
+  }
+  if (sizes.empty()) sizes = {1000, 100000, 300000};
+
+  for (size_t i = 0; i < sizes.size(); i++) {
+    Dfa dfa = RandomDfa(sizes[i]);
+    DfaTables tables = Compress(dfa);
+    DfaView view = tables.view();
+    std::vector<std::string> words = Words(dfa);
+    std::vector<const char*> begin;
+    std::vector<const char*> end;
+    int64_t bytes = 0;
+    for (size_t w = 0; w < words.size(); w++) {
+      begin.push_back(words[w].data());
+      end.push_back(words[w].data() + words[w].size());
+      bytes += words[w].size();
+    }
+    printf("%d states, %zu KB of tables, %zu words\n", sizes[i],
+           tables.bytes() / 1024, words.size());
+
+    // The same tokens, one Match() call after another
+    std::vector<DfaToken> matched;
+    matched.reserve(bytes / 4);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t w = 0; w < words.size(); w++) {
+      for (const char* p = begin[w]; p < end[w];) {
+        DfaToken found = {static_cast<int>(w), static_cast<int>(p - begin[w]),
+                          0, -1};
+        found.length = view.Match(p, end[w], &found.token);
+        if (found.length == 0) found.token = -1;
+        matched.push_back(found);
+        if (found.length == 0) break;
+        p += found.length;
+      }
+    }
+    double base = Seconds(start);
+    Report("Match() loop", bytes, matched.size(), base, base);
+
+    static const int lanes[] = {1, 4, 8, 16};
+    for (int l = 0; l < 4; l++) {
+      std::vector<DfaToken> tokens;
+      tokens.reserve(matched.size());
+      start = std::chrono::steady_clock::now();
+      view.Tokenize(begin.data(), end.data(), words.size(), lanes[l],
+                    &tokens);
+      double seconds = Seconds(start);
+      if (tokens.size() != matched.size() ||
+          memcmp(tokens.data(), matched.data(),
+                 tokens.size() * sizeof(DfaToken)) != 0) {
+        printf("  Tokenize() found other tokens than Match()\n");
+        return 1;
+      }
+      char what[32];
+      snprintf(what, sizeof(what), "Tokenize(), %d lanes", lanes[l]);
+      Report(what, bytes, tokens.size(), seconds, base);
+    }
+  }
+  return 0;
+}
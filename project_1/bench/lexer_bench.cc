@@ -0,0 +1,166 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Lexer throughput benchmark. For every size given on the command line (in
+ * MB, 1 to 1024) a token definition file of that size is generated into a
+ * temporary file, standard input is pointed at it and the LexicalAnalyzer
+ * constructor and the GetToken() loop are timed on their own. The regular
+ * expressions are not parsed and no NFA is built.
+ *
+ * Build and run from project_1 with
+ *
+ *     sh bench/run.sh [--pretokenize | --stream] [MB ...]
+ *
+ * Without a mode both modes are measured. PRETOKENIZE keeps every token in
+ * memory (sizeof(Token) per token), so use --stream for the largest sizes.
+ */
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../lexer.h"
+
+#define MB (1024L * 1024L)
+
+// ------- input generator -------------------
+
+static uint64_t seed = 340;
+
+static int Random(int n) {
+  seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return static_cast<int>((seed >> 33) % n);
+}
+
+static std::string Char() {
+  static const char chars[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+  return std::string(1, chars[Random(36)]);
+}
+
+// expr ::= CHAR | UNDERSCORE | (expr) | (expr) | (expr) | (expr) . (expr) |
+//          (expr) *
+static std::string Expr(int depth) {
+  switch (depth > 3 ? Random(2) : Random(5)) {
+    case 0:
+      return Char();
+    case 1:
+      return Random(4) == 0 ? "_" : Char();
+    case 2:
+      return "(" + Expr(depth + 1) + ")|(" + Expr(depth + 1) + ")";
+    case 3:
+      return "(" + Expr(depth + 1) + ").(" + Expr(depth + 1) + ")";
+    default:
+      return "(" + Expr(depth + 1) + ")*";
+  }
+}
+
+// Writes about "size" bytes to fd: nine tenths token definitions, the rest
+// one INPUT_TEXT of space separated symbols
+static void Generate(int fd, int64_t size) {
+  std::string out;
+  int64_t written = 0;
+  int64_t definitions = size - size / 10;
+  for (int i = 1; written + static_cast<int64_t>(out.size()) < definitions;
+       i++) {
+    out += (i == 1 ? "t" : " , t") + std::to_string(i) + " " + Expr(0);
+    if (i % 4 == 0) out += "\n";
+    if (out.size() >= 1 << 20) {
+      written += write(fd, out.data(), out.size());
+      out.clear();
+    }
+  }
+  out += " #\n\"";
+  while (written + static_cast<int64_t>(out.size()) < size - 2) {
+    int length = 1 + Random(8);
+    for (int j = 0; j < length; j++) out += Char();
+    out += Random(16) == 0 ? "\n" : " ";
+    if (out.size() >= 1 << 20) {
+      written += write(fd, out.data(), out.size());
+      out.clear();
+    }
+  }
+  out += "\"\n";
+  written += write(fd, out.data(), out.size());
+}
+
+// ------- timing -------------------
+
+static double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+static void Report(const char* what, int64_t bytes, int64_t tokens,
+                   double seconds) {
+  printf("  %-24s %9.3f s %10.1f MB/s %12.0f tokens/s\n", what, seconds,
+         bytes / seconds / MB, tokens / seconds);
+}
+
+// Lexes the file open on fd with a fresh lexer in the given mode
+static void Measure(int fd, int64_t bytes, LexerMode mode) {
+  lseek(fd, 0, SEEK_SET);
+  dup2(fd, STDIN_FILENO);
+  LexicalAnalyzer::SetMode(mode);
+
+  auto start = std::chrono::steady_clock::now();
+  LexicalAnalyzer lexer;
+  double construct = Seconds(start);
+
+  int64_t tokens = 0;
+  start = std::chrono::steady_clock::now();
+  while (lexer.GetToken().token_type != END_OF_FILE) tokens++;
+  double loop = Seconds(start);
+
+  if (mode == PRETOKENIZE) {
+    Report("constructor", bytes, tokens, construct);
+    Report("GetToken loop", bytes, tokens, loop);
+  } else {
+    Report("streaming GetToken loop", bytes, tokens, construct + loop);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  bool pretokenize = true;
+  bool streaming = true;
+  std::vector<int64_t> sizes;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--pretokenize") == 0) {
+      streaming = false;
+    } else if (strcmp(argv[i], "--stream") == 0) {
+      pretokenize = false;
+    } else if (atol(argv[i]) >= 1 && atol(argv[i]) <= 1024) {
+      sizes.push_back(atol(argv[i]));
+    } else {
+      printf("usage: %s [--pretokenize | --stream] [MB ...]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (sizes.empty()) sizes = {1, 16, 128};
+
+  for (size_t i = 0; i < sizes.size(); i++) {
+    char path[] = "/tmp/lexer_benchXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+      perror("mkstemp");
+      return 1;
+    }
+    unlink(path);
+    Generate(fd, sizes[i] * MB);
+    int64_t bytes = lseek(fd, 0, SEEK_END);
+
+    printf("%ld MB file (%ld bytes)\n", static_cast<long>(sizes[i]),
+           static_cast<long>(bytes));
+    if (pretokenize) Measure(fd, bytes, PRETOKENIZE);
+    if (streaming) Measure(fd, bytes, STREAMING);
+    close(fd);
+  }
+  return 0;
+}
@@ -0,0 +1,3 @@
+g++ -std=c++11 -O2 -pthread bench/lexer_bench.cc lexer.cc inputbuf.cc scanner.cc \
+    batch.cc pool.cc -o lexer_bench
+./lexer_bench "$@"
\ No newline at end of file
@@ -0,0 +1,2 @@
+g++ -std=c++11 -O2 bench/dfa_bench.cc dfa.cc -o dfa_bench
+./dfa_bench "$@"
\ No newline at end of file
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Scanner generator: a compiled token DFA written out as C++ source.
+ */
+#include "./codegen.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace {
+
+// The part of the generated program that does not depend on the tokens: it
+// reads the quoted input text, drops one space just inside each quote like
+// Parser::parse_input_text(), and prints the tokens of every space separated
+// word like myLexicalAnalyzer::my_get_token()
+const char kScannerMain[] =
+    "static void SyntaxError() {\n"
+    "  std::fputs(\"SNYTAX ERORR\\n\", stdout);\n"
+    "  std::exit(1);\n"
+    "}\n"
+    "\n"
+    "int main() {\n"
+    "  std::string input;\n"
+    "  char buffer[1 << 16];\n"
+    "  size_t n;\n"
+    "  while ((n = std::fread(buffer, 1, sizeof(buffer), stdin)) > 0) {\n"
+    "    input.append(buffer, n);\n"
+    "  }\n"
+    "\n"
+    "  const char* p = input.data();\n"
+    "  const char* end = p + input.size();\n"
+    "  while (p < end && std::isspace(static_cast<unsigned char>(*p))) p++;\n"
+    "  if (p == end || *p != '\"') SyntaxError();\n"
+    "  const char* text = ++p;\n"
+    "  while (p < end && (std::isalnum(static_cast<unsigned char>(*p)) ||\n"
+    "                     std::isspace(static_cast<unsigned char>(*p)))) {\n"
+    "    p++;\n"
+    "  }\n"
+    "  if (p == end || *p != '\"') SyntaxError();\n"
+    "  const char* text_end = p++;\n"
+    "  while (p < end && std::isspace(static_cast<unsigned char>(*p))) p++;\n"
+    "  if (p != end) SyntaxError();\n"
+    "\n"
+    "  if (text < text_end && *text == ' ') text++;\n"
+    "  if (text < text_end && text_end[-1] == ' ') text_end--;\n"
+    "  for (p = text; p < text_end;) {\n"
+    "    if (*p == ' ') {\n"
+    "      p++;\n"
+    "      continue;\n"
+    "    }\n"
+    "    const char* word_end = p;\n"
+    "    while (word_end < text_end && *word_end != ' ') word_end++;\n"
+    "    while (p < word_end) {\n"
+    "      int token;\n"
+    "      int length = Match(p, word_end, &token);\n"
+    "      if (length == 0) {\n"
+    "        std::fputs(\"ERROR\", stdout);\n"
+    "        return 0;\n"
+    "      }\n"
+    "      std::fputs(kTokenNames[token], stdout);\n"
+    "      std::fputs(\" , \\\"\", stdout);\n"
+    "      std::fwrite(p, 1, length, stdout);\n"
+    "      std::fputs(\"\\\"\\n\", stdout);\n"
+    "      p += length;\n"
+    "    }\n"
+    "  }\n"
+    "  return 0;\n"
+    "}\n";
+
+std::string ByteLiteral(int c) {
+  std::ostringstream literal;
+  if (std::isalnum(c)) {
+    literal << '\'' << static_cast<char>(c) << '\'';
+  } else {
+    literal << c;
+  }
+  return literal.str();
+}
+
+// Token names are IDs of the token section, but escape them anyway
+std::string StringLiteral(const std::string& s) {
+  std::string literal = "\"";
+  for (size_t i = 0; i < s.size(); i++) {
+    if (s[i] == '"' || s[i] == '\\') literal += '\\';
+    literal += s[i];
+  }
+  return literal + "\"";
+}
+
+void WriteMatch(std::ostream& out, const Dfa& dfa) {
+  std::vector<std::vector<int> > bytes(dfa.classes);
+  for (int c = 0; c < DFA_ALPHABET; c++) bytes[dfa.byte_class[c]].push_back(c);
+
+  // Only label the states something jumps to, so the source compiles without
+  // unused label warnings
+  std::vector<bool> target(dfa.size(), false);
+  for (size_t i = 0; i < dfa.next.size(); i++) {
+    if (dfa.next[i] != DFA_DEAD) target[dfa.next[i]] = true;
+  }
+
+  out << "// Returns the length of the longest token at the start of [p, end)"
+         " and sets\n"
+         "// token to it, or returns 0. Of the tokens that match that much,"
+         " the one\n"
+         "// declared first wins.\n"
+         "static int Match(const char* p, const char* end, int* token) {\n"
+         "  const char* q = p;\n"
+         "  int longest = 0;\n";
+  for (int s = 0; s < dfa.size(); s++) {
+    if (target[s]) out << "s" << s << ":\n";
+    if (dfa.token[s] >= 0) {
+      out << "  longest = static_cast<int>(q - p);\n"
+          << "  *token = " << dfa.token[s] << ";\n";
+    }
+
+    std::map<int, std::vector<int> > cases;  // bytes by next state
+    for (int k = 0; k < dfa.classes; k++) {
+      int next = dfa.next[s * dfa.classes + k];
+      if (next == DFA_DEAD) continue;
+      std::vector<int>& to = cases[next];
+      to.insert(to.end(), bytes[k].begin(), bytes[k].end());
+    }
+    if (cases.empty()) {
+      out << "  return longest;\n";
+      continue;
+    }
+    out << "  if (q == end) return longest;\n"
+        << "  switch (static_cast<unsigned char>(*q++)) {\n";
+    for (std::map<int, std::vector<int> >::iterator it = cases.begin();
+         it != cases.end(); ++it) {
+      for (size_t i = 0; i < it->second.size(); i++) {
+        out << "    case " << ByteLiteral(it->second[i]) << ":\n";
+      }
+      out << "      goto s" << it->first << ";\n";
+    }
+    out << "    default:\n"
+        << "      return longest;\n"
+        << "  }\n";
+  }
+  out << "}\n";
+}
+
+}  // namespace
+
+bool WriteScanner(const std::string& path, const Dfa& dfa,
+                  const std::vector<std::string>& names, std::string* error) {
+  std::ofstream out(path.c_str(), std::ios::trunc);
+  out << "// Scanner for " << names.size()
+      << " tokens, generated by project_1 --generate.\n"
+      << "\n"
+      << "#include <cctype>\n"
+      << "#include <cstdio>\n"
+      << "#include <cstdlib>\n"
+      << "#include <string>\n"
+      << "\n"
+      << "static const char* const kTokenNames[] = {\n";
+  for (size_t i = 0; i < names.size(); i++) {
+    out << "    " << StringLiteral(names[i]) << ",\n";
+  }
+  out << "};\n\n";
+  WriteMatch(out, dfa);
+  out << "\n" << kScannerMain;
+  out.close();
+  if (!out) {
+    *error = path + ": " + std::strerror(errno);
+    return false;
+  }
+  return true;
+}
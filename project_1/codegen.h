@@ -0,0 +1,26 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Scanner generator: a compiled token DFA written out as C++ source.
+ */
+#ifndef CODEGEN_H_
+#define CODEGEN_H_
+
+#include <string>
+#include <vector>
+
+#include "./dfa.h"
+
+// Writes a standalone C++ program to path that tokenizes an input text with
+// dfa the way my_get_token() does. Each DFA state becomes a label followed by
+// a switch on the next byte that jumps straight to the label of the next
+// state, so the scanner reads no tables at all. names are the token names in
+// declaration order.
+//
+// The generated program reads the same input as a run with --tables: only the
+// quoted input text. Returns false and sets error if the file cannot be
+// written.
+bool WriteScanner(const std::string& path, const Dfa& dfa,
+                  const std::vector<std::string>& names, std::string* error);
+
+#endif  // CODEGEN_H_
@@ -0,0 +1,427 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Compiled token DFAs: minimization and compressed transition tables.
+ */
+#include "./dfa.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <utility>
+
+namespace {
+
+// Blocks of states in Hopcroft's algorithm. The states of a block are kept
+// together in elements[first, end), and the states marked by the current
+// splitter are moved to the front of their block, ending at mid.
+struct Partition {
+  std::vector<int> elements;
+  std::vector<int> location;  // index of each state in elements
+  std::vector<int> block;     // block of each state
+  std::vector<int> first;
+  std::vector<int> mid;
+  std::vector<int> end;
+
+  int blocks() const { return static_cast<int>(first.size()); }
+
+  void Mark(int state, std::vector<int>* touched) {
+    int b = block[state];
+    int i = location[state];
+    if (i < mid[b]) return;
+    if (mid[b] == first[b]) touched->push_back(b);
+    int other = elements[mid[b]];
+    std::swap(elements[i], elements[mid[b]]);
+    location[other] = i;
+    location[state] = mid[b]++;
+  }
+
+  // Moves the marked states of b to a new block and returns it, or returns
+  // -1 if every state of b was marked
+  int Split(int b) {
+    if (mid[b] == end[b]) {
+      mid[b] = first[b];
+      return -1;
+    }
+    int c = blocks();
+    first.push_back(first[b]);
+    mid.push_back(first[b]);
+    end.push_back(mid[b]);
+    for (int i = first[b]; i < mid[b]; i++) block[elements[i]] = c;
+    first[b] = mid[b];
+    return c;
+  }
+};
+
+// Returns the first free slot of a comb vector at or after slot. A used slot
+// links to a later slot in next_free and a free one to itself; the links are
+// shortened on the way so that runs of used slots are skipped quickly.
+int FreeSlot(std::vector<int>* next_free, int slot) {
+  std::vector<int>& link = *next_free;
+  int n = static_cast<int>(link.size());
+  while (slot < n && link[slot] != slot) {
+    if (link[slot] < n) link[slot] = link[link[slot]];
+    slot = link[slot];
+  }
+  return slot;
+}
+
+}  // namespace
+
+Dfa Minimize(const Dfa& dfa) {
+  // State n stands for DFA_DEAD so that every state has every transition
+  int n = dfa.size() + 1;
+  int dead = n - 1;
+  int k = dfa.classes;
+  std::vector<int> next(dfa.next);
+  for (size_t i = 0; i < next.size(); i++) {
+    if (next[i] == DFA_DEAD) next[i] = dead;
+  }
+  next.resize(static_cast<size_t>(n) * k, dead);
+
+  // Sources of the transitions into each state, per class
+  std::vector<int> in_first(static_cast<size_t>(k) * n + 1, 0);
+  std::vector<int> in_states(static_cast<size_t>(n) * k);
+  for (int s = 0; s < n; s++) {
+    for (int c = 0; c < k; c++) in_first[c * n + next[s * k + c] + 1]++;
+  }
+  for (size_t i = 1; i < in_first.size(); i++) in_first[i] += in_first[i - 1];
+  std::vector<int> fill(in_first.begin(), in_first.end() - 1);
+  for (int s = 0; s < n; s++) {
+    for (int c = 0; c < k; c++) in_states[fill[c * n + next[s * k + c]]++] = s;
+  }
+
+  // Start with one block per accepted token, and one for the states that
+  // accept nothing
+  Partition p;
+  p.location.resize(n);
+  p.block.resize(n);
+  std::map<int, std::vector<int> > by_token;
+  for (int s = 0; s < n; s++) {
+    by_token[s == dead ? -1 : dfa.token[s]].push_back(s);
+  }
+  for (std::map<int, std::vector<int> >::iterator it = by_token.begin();
+       it != by_token.end(); ++it) {
+    int b = p.blocks();
+    p.first.push_back(p.elements.size());
+    p.mid.push_back(p.elements.size());
+    for (size_t i = 0; i < it->second.size(); i++) {
+      int s = it->second[i];
+      p.location[s] = p.elements.size();
+      p.block[s] = b;
+      p.elements.push_back(s);
+    }
+    p.end.push_back(p.elements.size());
+  }
+
+  std::vector<std::pair<int, int> > pending;  // (block, class) splitters
+  std::vector<char> is_pending;
+  for (int b = 0; b < p.blocks(); b++) {
+    for (int c = 0; c < k; c++) pending.push_back(std::make_pair(b, c));
+  }
+  is_pending.assign(static_cast<size_t>(p.blocks()) * k, 1);
+
+  std::vector<int> splitter;
+  std::vector<int> touched;
+  while (!pending.empty()) {
+    int a = pending.back().first;
+    int c = pending.back().second;
+    pending.pop_back();
+    is_pending[a * k + c] = 0;
+
+    splitter.assign(p.elements.begin() + p.first[a],
+                    p.elements.begin() + p.end[a]);
+    for (size_t i = 0; i < splitter.size(); i++) {
+      int t = splitter[i];
+      for (int j = in_first[c * n + t]; j < in_first[c * n + t + 1]; j++) {
+        p.Mark(in_states[j], &touched);
+      }
+    }
+
+    for (size_t i = 0; i < touched.size(); i++) {
+      int b = touched[i];
+      int nb = p.Split(b);
+      if (nb < 0) continue;
+      is_pending.resize(static_cast<size_t>(p.blocks()) * k, 0);
+      int smaller = p.end[nb] - p.first[nb] <= p.end[b] - p.first[b] ? nb : b;
+      for (int d = 0; d < k; d++) {
+        int add = is_pending[b * k + d] ? nb : smaller;
+        if (is_pending[add * k + d]) continue;
+        is_pending[add * k + d] = 1;
+        pending.push_back(std::make_pair(add, d));
+      }
+    }
+    touched.clear();
+  }
+
+  // Number the blocks in the order they are reached from the start state,
+  // and drop the block of the dead state
+  Dfa result;
+  result.classes = k;
+  std::memcpy(result.byte_class, dfa.byte_class, sizeof(dfa.byte_class));
+  std::vector<int> number(p.blocks(), DFA_DEAD);
+  std::vector<int> order;
+  if (p.block[0] != p.block[dead]) {
+    number[p.block[0]] = 0;
+    order.push_back(p.block[0]);
+  }
+  for (size_t i = 0; i < order.size(); i++) {
+    int s = p.elements[p.first[order[i]]];
+    result.token.push_back(dfa.token[s]);
+    for (int c = 0; c < k; c++) {
+      int b = p.block[next[s * k + c]];
+      if (b != p.block[dead] && number[b] == DFA_DEAD) {
+        number[b] = order.size();
+        order.push_back(b);
+      }
+      result.next.push_back(number[b]);
+    }
+  }
+  if (order.empty()) {
+    // Nothing can ever match; keep a start state with no transitions
+    result.token.push_back(-1);
+    result.next.assign(k, DFA_DEAD);
+  }
+  return result;
+}
+
+DfaTables Compress(const Dfa& dfa) {
+  int n = dfa.size();
+  int k = dfa.classes;
+  DfaTables tables;
+  tables.classes = k;
+  std::memcpy(tables.byte_class, dfa.byte_class, sizeof(dfa.byte_class));
+  tables.token = dfa.token;
+  tables.base.assign(n, 0);
+
+  // Place the fullest rows first, each at the lowest offset where its live
+  // entries land on free slots
+  std::vector<std::pair<int, int> > rows;  // (-live entries, state)
+  for (int s = 0; s < n; s++) {
+    int live = 0;
+    for (int c = 0; c < k; c++) live += dfa.next[s * k + c] != DFA_DEAD;
+    rows.push_back(std::make_pair(-live, s));
+  }
+  std::sort(rows.begin(), rows.end());
+
+  std::vector<int> next_free;
+  std::map<std::vector<int>, int> placed;  // last base by live columns
+  std::vector<int> columns;
+  for (size_t r = 0; r < rows.size() && rows[r].first < 0; r++) {
+    int s = rows[r].second;
+    columns.clear();
+    for (int c = 0; c < k; c++) {
+      if (dfa.next[s * k + c] != DFA_DEAD) columns.push_back(c);
+    }
+
+    // Try the bases that put the first entry on a free slot. Slots only fill
+    // up, so the bases below the one the last row with the same live columns
+    // got would still collide
+    std::map<std::vector<int>, int>::iterator last = placed.find(columns);
+    int lowest = last == placed.end() ? 0 : last->second + 1;
+    int base;
+    for (int slot = FreeSlot(&next_free, lowest + columns[0]);;
+         slot = FreeSlot(&next_free, slot + 1)) {
+      base = slot - columns[0];
+      size_t j = 1;
+      while (j < columns.size() &&
+             (base + columns[j] >= static_cast<int>(tables.check.size()) ||
+              tables.check[base + columns[j]] == DFA_DEAD)) {
+        j++;
+      }
+      if (j == columns.size()) break;
+    }
+    if (tables.check.size() < static_cast<size_t>(base + k)) {
+      tables.check.resize(base + k, DFA_DEAD);
+      tables.next.resize(base + k, DFA_DEAD);
+      for (int i = next_free.size(); i < base + k; i++) next_free.push_back(i);
+    }
+    tables.base[s] = base;
+    placed[columns] = base;
+    for (size_t j = 0; j < columns.size(); j++) {
+      tables.check[base + columns[j]] = s;
+      tables.next[base + columns[j]] = dfa.next[s * k + columns[j]];
+      next_free[base + columns[j]] = base + columns[j] + 1;
+    }
+  }
+  // Rows without live entries sit at 0 and find no slot of their own
+  if (tables.check.size() < static_cast<size_t>(k)) {
+    tables.check.resize(k, DFA_DEAD);
+    tables.next.resize(k, DFA_DEAD);
+  }
+  return tables;
+}
+
+int DfaView::Match(const char* p, const char* end, int* token) const {
+  int state = 0;
+  int longest = 0;
+  for (const char* q = p; q < end; q++) {
+    state = Next(state, *q);
+    if (state == DFA_DEAD) break;
+    if (this->token[state] >= 0) {
+      longest = q + 1 - p;
+      *token = this->token[state];
+    }
+  }
+  return longest;
+}
+
+void DfaView::Tokenize(const char* const* begin, const char* const* end,
+                       int n, int lanes, std::vector<DfaToken>* tokens) const {
+  // The walks in progress, one per lane. A lane always has a character left
+  // to read and a live state.
+  int input[DFA_MAX_LANES];
+  const char* start[DFA_MAX_LANES];  // of the token being matched
+  const char* p[DFA_MAX_LANES];
+  int state[DFA_MAX_LANES];
+  int longest[DFA_MAX_LANES];
+  int found[DFA_MAX_LANES];
+  int active = 0;
+  int next_input = 0;
+  size_t first = tokens->size();
+  std::vector<int> count(n + 1, 0);  // tokens per input, then offsets
+
+  lanes = std::max(1, std::min(lanes, DFA_MAX_LANES));
+  for (;;) {
+    // Put the next inputs on the free lanes
+    while (active < lanes && next_input < n) {
+      int i = next_input++;
+      if (begin[i] == end[i]) continue;
+      input[active] = i;
+      start[active] = p[active] = begin[i];
+      state[active] = 0;
+      longest[active] = 0;
+      active++;
+    }
+    if (active == 0) break;
+
+    // Advance every lane by one transition until one of them is done. The
+    // loop body has no branches that depend on the tables, so the loads of
+    // all lanes are issued together.
+    bool done = false;
+    while (!done) {
+      for (int i = 0; i < active; i++) {
+        int s = state[i];
+        int slot = base[s] + byte_class[static_cast<unsigned char>(*p[i]++)];
+        int t = check[slot] == s ? next[slot] : DFA_DEAD;
+        int accepts = token[t < 0 ? 0 : t];
+        bool more = t >= 0 && accepts >= 0;
+        longest[i] = more ? static_cast<int>(p[i] - start[i]) : longest[i];
+        found[i] = more ? accepts : found[i];
+        state[i] = t;
+        done |= t < 0 || p[i] == end[input[i]];
+      }
+    }
+
+    // Emit the longest match of every finished walk and start the next walk
+    // of its input, or free the lane if the input is used up
+    for (int i = 0; i < active;) {
+      const char* stop = end[input[i]];
+      if (state[i] >= 0 && p[i] < stop) {
+        i++;
+        continue;
+      }
+      DfaToken token = {input[i], static_cast<int>(start[i] - begin[input[i]]),
+                        longest[i], longest[i] > 0 ? found[i] : -1};
+      tokens->push_back(token);
+      count[input[i]]++;
+      if (longest[i] > 0 && start[i] + longest[i] < stop) {
+        start[i] = p[i] = start[i] + longest[i];
+        state[i] = 0;
+        longest[i] = 0;
+        i++;
+      } else {
+        active--;
+        input[i] = input[active];
+        start[i] = start[active];
+        p[i] = p[active];
+        state[i] = state[active];
+        longest[i] = longest[active];
+        found[i] = found[active];
+      }
+    }
+  }
+
+  // Lanes finish their inputs out of order, so sort the new tokens by input.
+  // Each input's tokens were found in order of offset already.
+  if (lanes == 1) return;
+  int offset = 0;
+  for (int i = 0; i <= n; i++) {
+    int c = count[i];
+    count[i] = offset;
+    offset += c;
+  }
+  std::vector<DfaToken> sorted(tokens->size() - first);
+  for (size_t i = first; i < tokens->size(); i++) {
+    sorted[count[(*tokens)[i].input]++] = (*tokens)[i];
+  }
+  std::copy(sorted.begin(), sorted.end(), tokens->begin() + first);
+}
+
+DfaView DfaTables::view() const {
+  DfaView view;
+  view.byte_class = byte_class;
+  view.token = token.data();
+  view.base = base.data();
+  view.next = next.data();
+  view.check = check.data();
+  return view;
+}
+
+Dfa BuildTrie(const std::vector<std::string>& literals,
+              const std::vector<int>& tokens) {
+  Dfa dfa;
+  std::memset(dfa.byte_class, 0, sizeof(dfa.byte_class));
+  dfa.classes = 1;
+  for (size_t i = 0; i < literals.size(); i++) {
+    for (size_t k = 0; k < literals[i].size(); k++) {
+      unsigned char c = literals[i][k];
+      if (dfa.byte_class[c] == 0) dfa.byte_class[c] = dfa.classes++;
+    }
+  }
+
+  dfa.next.assign(dfa.classes, DFA_DEAD);
+  dfa.token.assign(1, -1);
+  for (size_t i = 0; i < literals.size(); i++) {
+    int state = 0;
+    for (size_t k = 0; k < literals[i].size(); k++) {
+      int slot = state * dfa.classes +
+                 dfa.byte_class[static_cast<unsigned char>(literals[i][k])];
+      if (dfa.next[slot] == DFA_DEAD) {
+        dfa.next[slot] = dfa.size();
+        dfa.next.resize(dfa.next.size() + dfa.classes, DFA_DEAD);
+        dfa.token.push_back(-1);
+      }
+      state = dfa.next[slot];
+    }
+    if (dfa.token[state] < 0 || tokens[i] < dfa.token[state]) {
+      dfa.token[state] = tokens[i];
+    }
+  }
+  return dfa;
+}
+
+size_t DfaTables::bytes() const {
+  return sizeof(byte_class) +
+         sizeof(int) * (token.size() + base.size() + next.size() +
+                        check.size());
+}
+
+void PrintDfaStats(std::ostream& out, int tokens, const Dfa& subset,
+                   const Dfa& minimal, const DfaTables& tables) {
+  size_t subset_bytes = sizeof(int) * subset.size() * (DFA_ALPHABET + 1);
+  size_t class_bytes = sizeof(int) * minimal.size() * (minimal.classes + 1) +
+                       sizeof(minimal.byte_class);
+  out << "dfa: " << tokens << " tokens, " << minimal.classes
+      << " byte classes\n";
+  out << "  subset construction " << std::setw(7) << subset.size()
+      << " states " << std::setw(10) << subset_bytes
+      << " bytes as a 256 column table\n";
+  out << "  minimized           " << std::setw(7) << minimal.size()
+      << " states " << std::setw(10) << class_bytes
+      << " bytes as a byte class table\n";
+  out << "  comb vector         " << std::setw(7) << minimal.size()
+      << " states " << std::setw(10) << tables.bytes() << " bytes in "
+      << tables.next.size() << " slots\n";
+}
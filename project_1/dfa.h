@@ -0,0 +1,101 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Compiled token DFAs: minimization and compressed transition tables.
+ */
+#ifndef DFA_H_
+#define DFA_H_
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#define DFA_ALPHABET 256
+#define DFA_DEAD -1  // no NFA node left, nothing longer can match
+#define DFA_MAX_LANES 16
+
+// A complete DFA over byte classes. byte_class maps every byte to one of
+// "classes" columns, and bytes in the same class move every state to the same
+// state. next holds "classes" entries per state, DFA_DEAD where nothing can
+// match any more. token is the token a state accepts, -1 for none. State 0 is
+// the start state.
+struct Dfa {
+  int classes;
+  unsigned char byte_class[DFA_ALPHABET];
+  std::vector<int> next;
+  std::vector<int> token;
+
+  int size() const { return static_cast<int>(token.size()); }
+};
+
+// Returns the minimal DFA that accepts the same tokens, found with Hopcroft's
+// partition refinement. States that accept different tokens are never merged.
+Dfa Minimize(const Dfa& dfa);
+
+// Returns the trie of the non-empty strings literals as a DFA: a state per
+// prefix, accepting literals[i] as tokens[i]. Of equal literals, the smaller
+// token wins. Every byte of the literals gets a class of its own.
+Dfa BuildTrie(const std::vector<std::string>& literals,
+              const std::vector<int>& tokens);
+
+// A token found by DfaView::Tokenize()
+struct DfaToken {
+  int input;   // index of the input it was found in
+  int offset;  // where it starts in the input
+  int length;  // 0 if no token matches at offset
+  int token;   // -1 if no token matches at offset
+};
+
+// Read-only transition tables in row displacement ("comb vector") form. The
+// rows of all states are laid over one another in next at offsets
+// base[state], placed so that no two live entries share a slot. check records
+// the state each slot belongs to, and a slot that belongs to another state is
+// a dead transition. A view points either into a DfaTables or into a mapped
+// table file (see tables.h).
+struct DfaView {
+  const unsigned char* byte_class;
+  const int* token;
+  const int* base;
+  const int* next;
+  const int* check;
+
+  int Next(int state, char c) const {
+    int slot = base[state] + byte_class[static_cast<unsigned char>(c)];
+    return check[slot] == state ? next[slot] : DFA_DEAD;
+  }
+
+  // Returns the length of the longest prefix of [p, end) that is a token and
+  // sets token to it, or returns 0
+  int Match(const char* p, const char* end, int* token) const;
+
+  // Splits each of the n inputs [begin[i], end[i]) into tokens with the
+  // longest matches Match() would find, until the input ends or no token
+  // matches at some offset, and appends them to tokens ordered by input and
+  // offset. Up to lanes (1 to DFA_MAX_LANES) inputs are walked at once, one
+  // transition each in turn: a walk is a chain of dependent table loads, and
+  // interleaving independent chains keeps several cache misses in flight.
+  void Tokenize(const char* const* begin, const char* const* end, int n,
+                int lanes, std::vector<DfaToken>* tokens) const;
+};
+
+// The tables of a DfaView, built by Compress()
+struct DfaTables {
+  int classes;
+  unsigned char byte_class[DFA_ALPHABET];
+  std::vector<int> token;
+  std::vector<int> base;
+  std::vector<int> next;
+  std::vector<int> check;
+
+  DfaView view() const;
+  size_t bytes() const;
+};
+
+DfaTables Compress(const Dfa& dfa);
+
+// Prints the sizes of the DFA before and after minimization and compression
+void PrintDfaStats(std::ostream& out, int tokens, const Dfa& subset,
+                   const Dfa& minimal, const DfaTables& tables);
+
+#endif  // DFA_H_
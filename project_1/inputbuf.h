@@ -6,18 +6,64 @@
 #ifndef INPUTBUF_H_
 #define INPUTBUF_H_
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
+/*
+ * The whole input is made available as one contiguous block: standard input
+ * is memory mapped when it is redirected from a regular file and read into a
+ * single buffer otherwise. Characters are handed out by moving a cursor over
+ * the block, so ungetting a character that was just read only moves the
+ * cursor back. Characters that do not match the block are kept in
+ * input_buffer as before.
+ */
 class InputBuffer {
  public:
+  InputBuffer();
+  ~InputBuffer();
+
   void GetChar(char&);
   char UngetChar(char);
   std::string UngetString(std::string);
   bool EndOfInput();
 
+  // Direct access for the scanners: [Position(), End()) is the rest of the
+  // block and Seek() moves the cursor to a position inside it. Only
+  // meaningful while nothing foreign has been pushed back.
+  const char* Position();
+  const char* End();
+  void Seek(const char*);
+
+  // Makes buffers that are created afterwards on the calling thread read
+  // [data, data + size) instead of standard input, for batch mode.
+  // SetSource(NULL, 0) goes back to standard input.
+  static void SetSource(const char* data, size_t size);
+
+  // Makes buffers that are created afterwards stop reading standard input
+  // after the first chunk that contains c, so that the rest can be read by
+  // someone else. SetStopAfter('\0') reads everything again.
+  static void SetStopAfter(char c);
+
  private:
+  InputBuffer(const InputBuffer&) = delete;
+  InputBuffer& operator=(const InputBuffer&) = delete;
+
+  void Load();
+
+  static thread_local const char* source;
+  static thread_local size_t source_size;
+  static char stop_after;
+
   std::vector<char> input_buffer;
+  std::vector<char> block;
+  const char* data;
+  size_t size;
+  size_t pos;
+  void* mapping;
+  size_t mapping_size;
+  bool loaded;
+  bool eof;
 };
 
 #endif  // INPUTBUF_H_
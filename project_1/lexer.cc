@@ -6,34 +6,55 @@
 #include "./lexer.h"
 
 #include <cctype>
+#include <cstring>
 #include <iostream>
 #include <istream>
 #include <string>
 #include <vector>
 
+#include "./batch.h"
 #include "./inputbuf.h"
+#include "./scanner.h"
 
-const char* reserved[] = {"END_OF_FILE", "LPAREN",     "RPAREN", "HASH",
-                          "ID",          "COMMA",      "DOT",    "STAR",
-                          "OR",          "UNDERSCORE", "SYMBOL", "CHAR",
-                          "INPUT_TEXT",  "ERROR"};
+const char* reserved[] = {"END_OF_FILE", "LPAREN",     "RPAREN",   "HASH",
+                          "ID",          "COMMA",      "DOT",      "STAR",
+                          "OR",          "UNDERSCORE", "SYMBOL",   "CHAR",
+                          "INPUT_TEXT",  "PLUS",       "QUESTION", "CHAR_CLASS",
+                          "ERROR"};
 
 void Token::Print() {
-  std::cout << "{" << this->lexeme << " , "
-            << reserved[(static_cast<int>(this->token_type))] << " , "
-            << this->line_no << "}\n";
+  std::cout << "{";
+  std::cout.write(this->text, this->length);
+  std::cout << " , " << reserved[(static_cast<int>(this->token_type))]
+            << " , " << this->line_no << "}\n";
 }
 
-// The constructor function will get all token in the input and stores them in
-// an internal vector. This faciliates the implementation of peek()
+bool Token::SameLexeme(const Token& other) const {
+  return length == other.length && memcmp(text, other.text, length) == 0;
+}
+
+LexerMode LexicalAnalyzer::default_mode = PRETOKENIZE;
+
+// Selects the mode used by lexers constructed afterwards
+void LexicalAnalyzer::SetMode(LexerMode mode) { default_mode = mode; }
+
+// In PRETOKENIZE mode the constructor function will get all token in the
+// input and stores them in an internal vector. This faciliates the
+// implementation of peek(). In STREAMING mode nothing is read until the first
+// call to GetToken() or peek()
 LexicalAnalyzer::LexicalAnalyzer() {
   this->line_no = 1;
-  tmp.lexeme = "";
   tmp.line_no = 1;
   tmp.token_type = ERROR;
+  error_out = &std::cout;
+  mode = default_mode;
+  index = 0;
+  scanned = 0;
+  scanned_all = false;
+
+  if (mode == STREAMING) return;
 
   Token token = GetTokenMain();
-  index = 0;
 
   while (token.token_type != END_OF_FILE) {
     tokenList.push_back(token);  // push token into internal list
@@ -43,132 +64,113 @@ LexicalAnalyzer::LexicalAnalyzer() {
 }
 
 bool LexicalAnalyzer::SkipSpace() {
-  char c;
-  bool space_encountered = false;
+  const char* p = input.Position();
+  const char* q = ScanRun(p, input.End(), CC_SPACE, &line_no);
 
-  input.GetChar(c);
-  line_no += (c == '\n');
-
-  while (!input.EndOfInput() && isspace(c)) {
-    space_encountered = true;
-    input.GetChar(c);
-    line_no += (c == '\n');
-  }
-
-  if (!input.EndOfInput()) {
-    input.UngetChar(c);
-  }
-  return space_encountered;
+  input.Seek(q);
+  return q != p;
 }
 
+// ScanIdOrChar() is called with the cursor on a letter
 Token LexicalAnalyzer::ScanIdOrChar() {
-  char c;
-  input.GetChar(c);
-
-  if (isalpha(c)) {
-    tmp.lexeme = "";
-    int no = 0;
+  const char* p = input.Position();
+  const char* q = ScanRun(p + 1, input.End(), CC_ALNUM, NULL);
 
-    while (!input.EndOfInput() && isalnum(c)) {
-      tmp.lexeme += c;
-      input.GetChar(c);
-      no++;
-    }
-    tmp.line_no = line_no;
-    if (no == 1)
-      tmp.token_type = CHAR;
-    else
-      tmp.token_type = ID;
+  input.Seek(q);
+  tmp.text = p;
+  tmp.length = q - p;
+  tmp.line_no = line_no;
+  if (tmp.length == 1)
+    tmp.token_type = CHAR;
+  else
+    tmp.token_type = ID;
+  return tmp;
+}
 
-    if (!input.EndOfInput()) {
-      input.UngetChar(c);
-    }
+// The lexeme of INPUT_TEXT spans from the opening to the closing quote, so
+// it is a single view of the input however many symbols it contains.
+// ScanInput() is called with the cursor on the opening quote.
+Token LexicalAnalyzer::ScanInput() {
+  const char* start = input.Position();
+  const char* end = input.End();
+  const char* q = ScanSymbol(start + 1, end);
 
+  tmp.line_no = line_no;
+  if (q < end && *q == '"') {
+    input.Seek(q + 1);
+    tmp.text = start;
+    tmp.length = q + 1 - start;
+    tmp.token_type = INPUT_TEXT;
   } else {
-    if (!input.EndOfInput()) {
-      input.UngetChar(c);
-    }
-    tmp.lexeme = "";
+    input.Seek(q < end ? q + 1 : q);
+    tmp.length = 0;
     tmp.token_type = ERROR;
   }
   return tmp;
 }
 
-Token LexicalAnalyzer::ScanInput() {
-  char c;
-  input.GetChar(c);
-  std::string lexeme = "";
-  if (c == '"') {
-    tmp.lexeme = "";
-    lexeme += '"';
-    Token symbol = ScanSymbol();
-    while (symbol.token_type == SYMBOL) {
-      lexeme += symbol.lexeme;
-      symbol = ScanSymbol();
-    }
-    if (!input.EndOfInput()) {
-      input.GetChar(c);
-      if (c == '"') {
-        lexeme += c;
-        tmp.lexeme += lexeme;
-        tmp.token_type = INPUT_TEXT;
-      } else {
-        tmp.lexeme = "";
-        tmp.token_type = ERROR;
-      }
-
-    } else {
-      tmp.lexeme = "";
-      tmp.token_type = ERROR;
-    }
-
-    tmp.line_no = line_no;
+// The lexeme of CHAR_CLASS is the whole bracketed class, letters, digits and
+// '-' between '[' and ']'; Parser::parse_expr() reads the ranges in it.
+// ScanClass() is called with the cursor on the '['.
+Token LexicalAnalyzer::ScanClass() {
+  const char* start = input.Position();
+  const char* end = input.End();
+  const char* q = start + 1;
+  while (q < end && (IsClass(*q, CC_ALNUM) || *q == '-')) q++;
 
+  tmp.line_no = line_no;
+  if (q < end && *q == ']') {
+    input.Seek(q + 1);
+    tmp.text = start;
+    tmp.length = q + 1 - start;
+    tmp.token_type = CHAR_CLASS;
   } else {
-    if (!input.EndOfInput()) {
-      input.UngetChar(c);
-    }
-    tmp.lexeme = "";
+    input.Seek(q);
+    tmp.length = 0;
     tmp.token_type = ERROR;
   }
   return tmp;
 }
 
-Token LexicalAnalyzer::ScanSymbol() {
-  char c;
-  input.GetChar(c);
-  tmp.lexeme = "";
-  if (isspace(c) || isalnum(c)) {
-    // tmp.lexeme += c;
-    while (!input.EndOfInput() && (isspace(c) || isalnum(c))) {
-      line_no += (c == '\n');
-      tmp.lexeme += c;
-      input.GetChar(c);
-    }
-    if (!input.EndOfInput()) {
-      input.UngetChar(c);
-    }
-    tmp.line_no = line_no;
+// Symbols are the letters, digits and white space of an INPUT_TEXT. Returns
+// the end of the run of symbols starting at p.
+const char* LexicalAnalyzer::ScanSymbol(const char* p, const char* end) {
+  return ScanRun(p, end, CC_SPACE | CC_ALNUM, &line_no);
+}
 
-    tmp.token_type = SYMBOL;
-  } else {
-    if (!input.EndOfInput()) {
-      input.UngetChar(c);
+// Fill() scans tokens into the ring until the token "howFar" positions ahead
+// of index is available or the input is exhausted
+void LexicalAnalyzer::Fill(int howFar) {
+  while (!scanned_all && scanned < index + howFar) {
+    Token token = GetTokenMain();
+    if (token.token_type == END_OF_FILE) {
+      scanned_all = true;
+    } else {
+      ring[scanned % RING_SIZE] = token;
+      scanned++;
     }
-    tmp.lexeme = "";
-    tmp.token_type = ERROR;
   }
-  return tmp;
+}
+
+const Token& LexicalAnalyzer::EndOfFileToken() {
+  end_of_file.length = 0;
+  end_of_file.line_no = line_no;
+  end_of_file.token_type = END_OF_FILE;
+  return end_of_file;
 }
 
 // GetToken() accesses tokens from the tokenList that is populated when a
-// lexer object is instantiated
+// lexer object is instantiated, or from the ring in STREAMING mode
 Token LexicalAnalyzer::GetToken() {
+  if (mode == STREAMING) {
+    Fill(1);
+    if (index == scanned) return EndOfFileToken();
+    return ring[index++ % RING_SIZE];
+  }
+
   Token token;
   if (index == (static_cast<int>(tokenList.size()))) {  // return end of file if
-    token.lexeme = "";                                  // index is too large
-    token.line_no = line_no;
-    token.token_type = END_OF_FILE;
+    token = EndOfFileToken();                           // index is too large
   } else {
     token = tokenList[index];
     index = index + 1;
@@ -176,37 +178,43 @@ Token LexicalAnalyzer::GetToken() {
   return token;
 }
 
-// peek requires that the argument "howFar" be positive.
-Token LexicalAnalyzer::peek(int howFar) {
+// peek requires that the argument "howFar" be positive. The returned
+// reference is valid until the next call to GetToken().
+const Token& LexicalAnalyzer::peek(int howFar) {
   if (howFar <= 0) {  // peeking backward or in place is not allowed
-    std::cout << "LexicalAnalyzer:peek:Error: non positive argument\n";
-    exit(-1);
+    *error_out << "LexicalAnalyzer:peek:Error: non positive argument\n";
+    Exit(-1);
+  }
+
+  if (mode == STREAMING) {
+    if (howFar >= RING_SIZE) {  // only RING_SIZE - 1 tokens are kept ahead
+      *error_out << "LexicalAnalyzer:peek:Error: argument exceeds lookahead\n";
+      Exit(-1);
+    }
+    Fill(howFar);
+    if (index + howFar > scanned) return EndOfFileToken();
+    return ring[(index + howFar - 1) % RING_SIZE];
   }
 
   int peekIndex = index + howFar - 1;
   if (peekIndex >
       (static_cast<int>(tokenList.size())) - 1) {  // if peeking too far
-    Token token;                                   // return END_OF_FILE
-    token.lexeme = "";
-    token.line_no = line_no;
-    token.token_type = END_OF_FILE;
-    return token;
+    return EndOfFileToken();                       // return END_OF_FILE
   } else {
     return tokenList[peekIndex];
   }
 }
 
 Token LexicalAnalyzer::GetTokenMain() {
-  char c;
-
   SkipSpace();
-  tmp.lexeme = "";
+  tmp.length = 0;
   tmp.line_no = line_no;
   tmp.token_type = END_OF_FILE;
-  if (!input.EndOfInput())
-    input.GetChar(c);
-  else
-    return tmp;
+
+  const char* p = input.Position();
+  if (p == input.End()) return tmp;
+  char c = *p;
+  input.Seek(p + 1);
 
   switch (c) {
     case '(':
@@ -227,27 +235,34 @@ Token LexicalAnalyzer::GetTokenMain() {
     case '|':
       tmp.token_type = OR;
       return tmp;
+    case '+':
+      tmp.token_type = PLUS;
+      return tmp;
+    case '?':
+      tmp.token_type = QUESTION;
+      return tmp;
+    case '[':
+      input.Seek(p);
+      return ScanClass();
     case '#':
+      // The lexeme is empty and ends where the input text section starts
       tmp.token_type = HASH;
+      tmp.text = p + 1;
       return tmp;
     case '_':
       tmp.token_type = UNDERSCORE;
       return tmp;
     case '"':
-      input.UngetChar(c);
+      input.Seek(p);
       return ScanInput();
     default:
-      if (isdigit(c)) {
-        // CHAR
-        // input.UngetChar(c);
-        // return ScanNumber();
+      if (IsClass(c, CC_DIGIT)) {
         tmp.token_type = CHAR;
-        tmp.lexeme = c;
-      } else if (isalpha(c)) {
-        input.UngetChar(c);
+        tmp.text = p;
+        tmp.length = 1;
+      } else if (IsClass(c, CC_ALPHA)) {
+        input.Seek(p);
         return ScanIdOrChar();
-      } else if (input.EndOfInput()) {
-        tmp.token_type = END_OF_FILE;
       } else {
         tmp.token_type = ERROR;
       }
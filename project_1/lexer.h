@@ -6,6 +6,7 @@
 #ifndef LEXER_H_
 #define LEXER_H_
 
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -27,14 +28,32 @@ typedef enum {
   SYMBOL,
   CHAR,
   INPUT_TEXT,
+  PLUS,
+  QUESTION,
+  CHAR_CLASS,
   ERROR
 } TokenType;
 
+// ------- lexer modes -------------------
+//
+// PRETOKENIZE scans the whole input in the constructor. STREAMING scans
+// tokens on demand and keeps only the last RING_SIZE tokens, which bounds
+// peek() to RING_SIZE - 1 tokens ahead.
+
+typedef enum { PRETOKENIZE = 0, STREAMING } LexerMode;
+
+#define RING_SIZE 4
+
+// A token is a small value type. Its lexeme is not copied: text points into
+// the input buffer and stays valid for the lifetime of the lexer.
 class Token {
  public:
   void Print();
+  std::string lexeme() const { return std::string(text, length); }
+  bool SameLexeme(const Token& other) const;
 
-  std::string lexeme;
+  const char* text = "";
+  int length = 0;
   TokenType token_type;
   int line_no;
 };
@@ -42,11 +61,30 @@ class Token {
 class LexicalAnalyzer {
  public:
   Token GetToken();
-  Token peek(int);
+  const Token& peek(int);
   LexicalAnalyzer();
 
+  static void SetMode(LexerMode);
+
+  // Where the errors of peek() go, std::cout unless the lexer belongs to a
+  // program that writes its output elsewhere
+  void SetErrorOutput(std::ostream& out) { error_out = &out; }
+
+  // End of the input read so far, for reading on past the lexer
+  const char* InputEnd() { return input.End(); }
+
  private:
+  static LexerMode default_mode;
+
+  LexerMode mode;
+  std::ostream* error_out;
   std::vector<Token> tokenList;
+  Token ring[RING_SIZE];
+  int scanned;
+  bool scanned_all;
+  Token end_of_file;
+  void Fill(int);
+  const Token& EndOfFileToken();
   Token GetTokenMain();
   int line_no;
   int index;
@@ -55,8 +93,9 @@ class LexicalAnalyzer {
 
   bool SkipSpace();
   Token ScanIdOrChar();
-  Token ScanSymbol();
+  const char* ScanSymbol(const char*, const char*);
   Token ScanInput();
+  Token ScanClass();
 };
 
 #endif  // LEXER_H_
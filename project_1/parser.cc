@@ -18,19 +18,32 @@
  */
 #include "./parser.h"
 
+#include <unistd.h>
+
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <istream>
-#include <set>
+#include <map>
 #include <sstream>
 #include <vector>
 
-// Definition of vector to track token values to assist in raising expression
-// syntax error when required.
-std::vector<Token> track_token;
-std::vector<std::string> track_semantic_error_messages;
+#include "./batch.h"
+#include "./codegen.h"
+#include "./pool.h"
+#include "./textstream.h"
+
+/*
+ * A parser handles one program and writes everything it prints to out. All
+ * of its state lives in the parser, so parsers on different threads do not
+ * share anything.
+ */
+Parser::Parser(std::ostream &out) : out(out), my_lexer(out) {
+  lexer.SetErrorOutput(out);
+}
 
 // The below set of code is to read the input provided in the Token section
 
@@ -38,8 +51,8 @@ std::vector<std::string> track_semantic_error_messages;
  * Function provides a simplified way of throwing general syntax error.
  */
 void Parser::syntax_error() {
-  std::cout << "SNYTAX ERORR" << std::endl;
-  exit(1);
+  out << "SNYTAX ERORR" << std::endl;
+  Exit(1);
 }
 
 /*
@@ -48,8 +61,8 @@ void Parser::syntax_error() {
  * Written by: Kaustubh Manoj Harapanahalli
  */
 void Parser::expression_syntax_error(Token token_id) {
-  std::cout << "SYNTAX ERROR IN EXPRESSION OF " + token_id.lexeme << std::endl;
-  exit(1);
+  out << "SYNTAX ERROR IN EXPRESSION OF " + token_id.lexeme() << std::endl;
+  Exit(1);
 }
 
 /*
@@ -60,9 +73,9 @@ void Parser::expression_syntax_error(Token token_id) {
 void Parser::semantic_error() {
   for (int i = 0; i < static_cast<int>(track_semantic_error_messages.size());
        i++) {
-    std::cout << track_semantic_error_messages[i] << std::endl;
+    out << track_semantic_error_messages[i] << std::endl;
   }
-  exit(1);
+  Exit(1);
 }
 
 /*
@@ -154,18 +167,86 @@ void Parser::parseInput() {
 void Parser::parse_input() {
   parse_tokens_section();
   // TODO(kaustubh): myLexicalAnalysis to be added here.
+  parse_input_text();
+}
+
+/*
+ * Entry point when the tokens come from a table file: the input holds only the
+ * input data, which is analyzed with the tokens of the table file.
+ *
+ * GRAMMAR:
+ * INPUT_TEXT END_OF_FILE
+ */
+void Parser::parseInputText() {
+  parse_input_text();
+  expect(END_OF_FILE);
+  my_lexer.my_get_token();
+}
+
+/*
+ * Entry point for --stream-text. The token section is parsed as usual, but the
+ * input data after the HASH is read in chunks and tokenized while it is read
+ * instead of being read into memory as a whole.
+ *
+ * GRAMMAR:
+ * input -> tokens_section INPUT_TEXT END_OF_FILE
+ */
+void Parser::parseStreamedInput() {
+  parse_token_list();
+  Token hash = expect(HASH);
+  TextStream text(STDIN_FILENO, hash.text, lexer.InputEnd());
+  scan_streamed_text(&text);
+}
+
+/*
+ * Entry point for --stream-text with a table file: the input holds only the
+ * input data.
+ *
+ * GRAMMAR:
+ * INPUT_TEXT END_OF_FILE
+ */
+void Parser::parseStreamedInputText() {
+  TextStream text(STDIN_FILENO, NULL, NULL);
+  scan_streamed_text(&text);
+}
+
+/*
+ * Semantic errors are reported only if the input data is well formed, as in
+ * parseInput(). Tokens are printed while the input data is read, though, so
+ * a syntax error in it is reported after the tokens of the words before it.
+ */
+void Parser::scan_streamed_text(TextStream *text) {
+  if (!track_semantic_error_messages.empty()) {
+    if (!text->Validate()) syntax_error();
+    semantic_error();
+  }
+  if (!my_lexer.my_get_token_stream(text)) syntax_error();
+}
+
+/*
+ * Function to parse the input data and hand it to myLexicalAnalyzer, without
+ * the spaces just inside the quotes.
+ *
+ * GRAMMAR:
+ * input_text -> INPUT_TEXT
+ */
+void Parser::parse_input_text() {
   Token token_object = expect(INPUT_TEXT);
 
-  std::string temp =
-      token_object.lexeme.substr(1, token_object.lexeme.size() - 2);
+  // An empty text, or one that is a single space, has no words
+  std::string temp(token_object.text + 1, token_object.length - 2);
+  if (temp.empty()) syntax_error();
+  size_t offset = 0;
   if (temp.at(0) == ' ') {
     temp = temp.substr(1, temp.size());
+    offset = 1;
   }
+  if (temp.empty()) syntax_error();
   if (temp.at(temp.size() - 1) == ' ') {
     temp = temp.substr(0, temp.size() - 1);
   }
   //    cout << "Input string :" << temp << endl;
-  my_lexer.set_input_string(temp);
+  my_lexer.set_input_string(temp, offset);
 }
 
 /*
@@ -193,7 +274,7 @@ void Parser::parse_tokens_section() {
  */
 void Parser::parse_token_list() {
   parse_token();
-  Token token_object = lexer.peek(1);
+  const Token &token_object = lexer.peek(1);
   if (token_object.token_type == COMMA) {
     expect(COMMA);
     parse_token_list();
@@ -222,12 +303,12 @@ void Parser::parse_token() {
   // Check for semantic error
   if (track_token.size() != 0) {
     for (int i = 0; i < static_cast<int>(track_token.size()); i++) {
-      if (track_token[i].lexeme == token_id.lexeme) {
+      if (track_token[i].SameLexeme(token_id)) {
         counter = 1;
         std::string semantic_error_message;
 
         semantic_error_message = "Line " + std::to_string(token_id.line_no) +
-                                 ": " + track_token[i].lexeme +
+                                 ": " + track_token[i].lexeme() +
                                  " already declared on line " +
                                  std::to_string(track_token[i].line_no);
 
@@ -243,9 +324,9 @@ void Parser::parse_token() {
     track_token.push_back(token_id);
   }
 
-  RegularExpressionGraph *reg = parse_expr(token_id);
+  RegularExpressionGraph reg = parse_expr(token_id);
   tokenReg tok;
-  tok.token_name = token_id.lexeme;
+  tok.token_name = token_id.lexeme();
   tok.reg = reg;
   my_lexer.set_tokens_list(tok);
 }
@@ -257,86 +338,122 @@ void Parser::parse_token() {
  *
  * GRAMMAR:
  * expr -> CHAR
+ * expr -> CHAR_CLASS
  * expr -> LPAREN expr RPAREN DOT LPAREN expr RPAREN
  * expr -> LPAREN expr RPAREN OR LPAREN expr RPAREN
  * expr -> LPAREN expr RPAREN STAR
+ * expr -> LPAREN expr RPAREN PLUS
+ * expr -> LPAREN expr RPAREN QUESTION
  * expr -> UNDERSCORE
  *
  * Written by: Kaustubh Manoj Harapanahalli
  */
-struct RegularExpressionGraph *Parser::parse_expr(Token token_id) {
-  Token token_object_1 = lexer.peek(1);
+struct RegularExpressionGraph Parser::parse_expr(Token token_id) {
+  const Token &token_object_1 = lexer.peek(1);
+  RegularExpressionArena *nfa = my_lexer.get_arena();
+  RegularExpressionGraph reg = {0, 0};
 
   if (token_object_1.token_type == CHAR) {
     Token t = expect_expr(CHAR, token_id);
 
-    RegularExpressionGraph *reg = new RegularExpressionGraph();
-    RegularExpressionNode *reg_node_1 = new RegularExpressionNode();
+    reg.start = nfa->add_node();
+    reg.accept = nfa->add_node();
+    nfa->first_label[reg.start] = t.text[0];
+    nfa->first_neighbor[reg.start] = reg.accept;
+    return reg;
 
-    reg_node_1->reg_id = my_lexer.get_counter();
-    reg_node_1->first_label = t.lexeme.at(0);
-    RegularExpressionNode *node2 = new RegularExpressionNode();
-    node2->reg_id = my_lexer.get_counter();
-    reg_node_1->first_neighbor = node2;
-    reg->start = reg_node_1;
-    reg->accept = node2;
+  } else if (token_object_1.token_type == CHAR_CLASS) {
+    Token t = expect_expr(CHAR_CLASS, token_id);
+    ByteSet set;
+    if (!parse_class(t, &set)) expression_syntax_error(token_id);
+
+    // Classes with the same bytes share their set
+    int id = std::find(nfa->class_sets.begin() + 1, nfa->class_sets.end(),
+                       set) -
+             nfa->class_sets.begin();
+    if (id == static_cast<int>(nfa->class_sets.size())) {
+      nfa->class_sets.push_back(set);
+    }
+    reg.start = nfa->add_node();
+    reg.accept = nfa->add_node();
+    nfa->first_label[reg.start] = CLASS_LABEL;
+    nfa->first_class[reg.start] = id;
+    nfa->first_neighbor[reg.start] = reg.accept;
     return reg;
 
   } else if (token_object_1.token_type == LPAREN) {
     expect_expr(LPAREN, token_id);
-    RegularExpressionGraph *reg1 = parse_expr(token_id);
+    RegularExpressionGraph reg1 = parse_expr(token_id);
     expect_expr(RPAREN, token_id);
 
-    Token token_object_2 = lexer.peek(1);
+    const Token &token_object_2 = lexer.peek(1);
 
     if (token_object_2.token_type == DOT) {
       expect_expr(DOT, token_id);
       expect_expr(LPAREN, token_id);
-      RegularExpressionGraph *reg2 = parse_expr(token_id);
+      RegularExpressionGraph reg2 = parse_expr(token_id);
       expect_expr(RPAREN, token_id);
-      reg1->accept->first_neighbor = reg2->start;
-      reg1->accept->first_label = '_';
-      reg1->accept = reg2->accept;
+      nfa->first_neighbor[reg1.accept] = reg2.start;
+      nfa->first_label[reg1.accept] = '_';
+      reg1.accept = reg2.accept;
       return reg1;
 
     } else if (token_object_2.token_type == OR) {
       expect_expr(OR, token_id);
       expect_expr(LPAREN, token_id);
-      RegularExpressionGraph *reg2 = parse_expr(token_id);
+      RegularExpressionGraph reg2 = parse_expr(token_id);
       expect_expr(RPAREN, token_id);
-      RegularExpressionNode *start = new RegularExpressionNode();
-      start->reg_id = my_lexer.get_counter();
-      start->first_label = '_';
-      start->second_label = '_';
-      start->first_neighbor = reg1->start;
-      start->second_neighbor = reg2->start;
-      RegularExpressionNode *accept = new RegularExpressionNode();
-      accept->reg_id = my_lexer.get_counter();
-      reg1->accept->first_label = '_';
-      reg1->accept->first_neighbor = accept;
-      reg2->accept->first_label = '_';
-      reg2->accept->first_neighbor = accept;
-      reg1->start = start;
-      reg1->accept = accept;
-      return reg1;
+      reg.start = nfa->add_node();
+      nfa->first_label[reg.start] = '_';
+      nfa->second_label[reg.start] = '_';
+      nfa->first_neighbor[reg.start] = reg1.start;
+      nfa->second_neighbor[reg.start] = reg2.start;
+      reg.accept = nfa->add_node();
+      nfa->first_label[reg1.accept] = '_';
+      nfa->first_neighbor[reg1.accept] = reg.accept;
+      nfa->first_label[reg2.accept] = '_';
+      nfa->first_neighbor[reg2.accept] = reg.accept;
+      return reg;
 
     } else if (token_object_2.token_type == STAR) {
       expect_expr(STAR, token_id);
-      RegularExpressionNode *start = new RegularExpressionNode();
-      start->reg_id = my_lexer.get_counter();
-      start->first_label = '_';
-      start->second_label = '_';
-      start->first_neighbor = reg1->start;
-      RegularExpressionNode *accept = new RegularExpressionNode();
-      accept->reg_id = my_lexer.get_counter();
-      start->second_neighbor = accept;
-      reg1->accept->first_label = '_';
-      reg1->accept->first_neighbor = accept;
-      reg1->accept->second_label = '_';
-      reg1->accept->second_neighbor = reg1->start;
-      reg1->start = start;
-      reg1->accept = accept;
-      return reg1;
+      reg.start = nfa->add_node();
+      nfa->first_label[reg.start] = '_';
+      nfa->second_label[reg.start] = '_';
+      nfa->first_neighbor[reg.start] = reg1.start;
+      reg.accept = nfa->add_node();
+      nfa->second_neighbor[reg.start] = reg.accept;
+      nfa->first_label[reg1.accept] = '_';
+      nfa->first_neighbor[reg1.accept] = reg.accept;
+      nfa->second_label[reg1.accept] = '_';
+      nfa->second_neighbor[reg1.accept] = reg1.start;
+      return reg;
+
+    } else if (token_object_2.token_type == PLUS) {
+      // Like STAR without the edge that skips reg1
+      expect_expr(PLUS, token_id);
+      reg.start = nfa->add_node();
+      nfa->first_label[reg.start] = '_';
+      nfa->first_neighbor[reg.start] = reg1.start;
+      reg.accept = nfa->add_node();
+      nfa->first_label[reg1.accept] = '_';
+      nfa->first_neighbor[reg1.accept] = reg.accept;
+      nfa->second_label[reg1.accept] = '_';
+      nfa->second_neighbor[reg1.accept] = reg1.start;
+      return reg;
+
+    } else if (token_object_2.token_type == QUESTION) {
+      // Like STAR without the edge that repeats reg1
+      expect_expr(QUESTION, token_id);
+      reg.start = nfa->add_node();
+      nfa->first_label[reg.start] = '_';
+      nfa->second_label[reg.start] = '_';
+      nfa->first_neighbor[reg.start] = reg1.start;
+      reg.accept = nfa->add_node();
+      nfa->second_neighbor[reg.start] = reg.accept;
+      nfa->first_label[reg1.accept] = '_';
+      nfa->first_neighbor[reg1.accept] = reg.accept;
+      return reg;
 
     } else {
       expression_syntax_error(token_id);
@@ -344,110 +461,481 @@ struct RegularExpressionGraph *Parser::parse_expr(Token token_id) {
 
   } else if (token_object_1.token_type == UNDERSCORE) {
     expect_expr(UNDERSCORE, token_id);
-    RegularExpressionGraph *reg = new RegularExpressionGraph();
-    RegularExpressionNode *node1 = new RegularExpressionNode();
-    node1->reg_id = my_lexer.get_counter();
-    node1->first_label = '_';
-    RegularExpressionNode *node2 = new RegularExpressionNode();
-    node2->reg_id = my_lexer.get_counter();
-    node1->first_neighbor = node2;
-    reg->start = node1;
-    reg->accept = node2;
+    reg.start = nfa->add_node();
+    nfa->first_label[reg.start] = '_';
+    reg.accept = nfa->add_node();
+    nfa->first_neighbor[reg.start] = reg.accept;
     return reg;
 
   } else {
     expression_syntax_error(token_id);
   }
 
-  return NULL;
+  return reg;
+}
+
+/*
+ * Reads the bytes of a CHAR_CLASS lexeme like [a-z0-9] into set. A class
+ * lists single letters and digits and ranges between two digits, two
+ * lowercase or two uppercase letters. Returns false if the class is empty or
+ * a range is not one of those.
+ */
+bool Parser::parse_class(const Token &token, ByteSet *set) {
+  const char *p = token.text + 1;
+  const char *end = token.text + token.length - 1;
+  if (p == end) return false;
+  while (p < end) {
+    char low = *p++;
+    char high = low;
+    if (p < end && *p == '-') {
+      if (p + 1 == end) return false;
+      high = p[1];
+      p += 2;
+      bool same_kind = (isdigit(low) && isdigit(high)) ||
+                       (islower(low) && islower(high)) ||
+                       (isupper(low) && isupper(high));
+      if (!same_kind || high < low) return false;
+    }
+    if (low == '-') return false;
+    for (int c = low; c <= high; c++) set->set(c);
+  }
+  return true;
+}
+
+/*
+ * Fills closures with the epsilon closure of every node, found by a depth
+ * first search along the '_' edges.
+ */
+void myLexicalAnalyzer::find_closures() {
+  int n = arena.size();
+  closures.assign(n, Closure());
+  std::vector<int> seen(n, 0);
+  for (int id = 1; id < n; id++) {
+    std::vector<int> members;
+    std::vector<int> stack(1, id);
+    seen[id] = id;
+    while (!stack.empty()) {
+      int node = stack.back();
+      stack.pop_back();
+      members.push_back(node);
+      int next[2] = {0, 0};
+      if (arena.first_label[node] == '_') next[0] = arena.first_neighbor[node];
+      if (arena.second_label[node] == '_') {
+        next[1] = arena.second_neighbor[node];
+      }
+      for (int k = 0; k < 2; k++) {
+        if (next[k] != 0 && seen[next[k]] != id) {
+          seen[next[k]] = id;
+          stack.push_back(next[k]);
+        }
+      }
+    }
+
+    Closure &closure = closures[id];
+    int low = *std::min_element(members.begin(), members.end()) / 64;
+    int high = *std::max_element(members.begin(), members.end()) / 64;
+    closure.first_word = low;
+    closure.bits.assign(high - low + 1, 0);
+    for (size_t k = 0; k < members.size(); k++) {
+      closure.bits[members[k] / 64 - low] |= uint64_t(1) << (members[k] % 64);
+    }
+  }
+}
+
+// Adds the epsilon closure of node reg_id to S
+void myLexicalAnalyzer::add_closure(NodeSet *S, int reg_id) {
+  const Closure &closure = closures[reg_id];
+  for (size_t k = 0; k < closure.bits.size(); k++) {
+    (*S)[closure.first_word + k] |= closure.bits[k];
+  }
 }
 
 /*
  * Function definition for matching single characters between the generated
- * graph and the input string. Generates a set of Regular Expression Graph IDs
- * based on the input character.
+ * graph and the input string. Returns the epsilon closure of the nodes that
+ * the nodes in S reach over an edge labelled c, or over a class edge whose
+ * class holds c. Edges labelled '_' are the epsilon edges, so c == '_' follows
+ * those.
  *
  * Written by: Kaustubh Manoj Harapanahalli
  */
-std::set<RegularExpressionNode> myLexicalAnalyzer::match_one_char(
-    std::set<RegularExpressionNode> S, char c) {
-  std::set<RegularExpressionNode> S1;
-  std::set<RegularExpressionNode>::iterator it;
-  for (it = S.begin(); it != S.end(); ++it) {
-    if (it->first_label == c && !check_node(S1, it->first_neighbor)) {
-      S1.insert(*it->first_neighbor);
+NodeSet myLexicalAnalyzer::match_one_char(const NodeSet &S, char c) {
+  NodeSet S1(S.size(), 0);
+  for (size_t w = 0; w < S.size(); w++) {
+    for (uint64_t bits = S[w]; bits != 0; bits &= bits - 1) {
+      int node = w * 64 + __builtin_ctzll(bits);
+      if (arena.takes(node, arena.first_label[node], c) &&
+          arena.first_neighbor[node] != 0) {
+        add_closure(&S1, arena.first_neighbor[node]);
+      }
+      if (arena.second_label[node] == c && arena.second_neighbor[node] != 0) {
+        add_closure(&S1, arena.second_neighbor[node]);
+      }
     }
+  }
+  return S1;
+}
 
-    if (it->second_label == c && !check_node(S1, it->second_neighbor)) {
-      S1.insert(*it->second_neighbor);
+/*
+ * Adds the epsilon closure of the start node of a token to the start state of
+ * a DFA and tags the accept node of the token.
+ */
+void myLexicalAnalyzer::dfa_add_token(LazyDfa *dfa,
+                                      const RegularExpressionGraph &reg,
+                                      int token) {
+  if (closures.empty()) find_closures();
+  dfa->start.resize((arena.size() - 1) / 64 + 1, 0);
+  add_closure(&dfa->start, reg.start);
+
+  int accept_id = reg.accept;
+  if (accept_id >= static_cast<int>(dfa->token_of.size())) {
+    dfa->token_of.resize(accept_id + 1, -1);
+  }
+  dfa->token_of[accept_id] = token;
+}
+
+/*
+ * Returns the lazy DFA of a single token, starting it the first time the token
+ * is matched.
+ */
+LazyDfa *myLexicalAnalyzer::dfa_for(const RegularExpressionGraph &reg) {
+  LazyDfa *dfa = &dfas[reg.start];
+  if (dfa->states.empty()) {
+    dfa_add_token(dfa, reg, 0);
+    dfa_add_state(dfa, dfa->start);
+  }
+  return dfa;
+}
+
+/*
+ * Returns the lazy DFA of all tokens in tokens_list, tagged with their index.
+ */
+LazyDfa *myLexicalAnalyzer::dfa_for_all() {
+  LazyDfa *dfa = &all_tokens;
+  if (dfa->states.empty()) {
+    for (int i = 0; i < static_cast<int>(tokens_list.size()); i++) {
+      dfa_add_token(dfa, tokens_list[i].reg, i);
+    }
+    dfa_add_state(dfa, dfa->start);
+  }
+  return dfa;
+}
+
+/*
+ * Returns the earliest declared token that a node in S accepts, or -1.
+ */
+int myLexicalAnalyzer::dfa_accepts(const LazyDfa *dfa, const NodeSet &S) {
+  int token = -1;
+  for (size_t w = 0; w < S.size(); w++) {
+    for (uint64_t bits = S[w]; bits != 0; bits &= bits - 1) {
+      size_t id = w * 64 + __builtin_ctzll(bits);
+      if (id < dfa->token_of.size() && dfa->token_of[id] >= 0 &&
+          (token < 0 || dfa->token_of[id] < token)) {
+        token = dfa->token_of[id];
+      }
     }
   }
+  return token;
+}
 
-  if (S1.empty()) {
-    return S1;
+/*
+ * Adds the DFA state for the set of NFA nodes S, which must not have a state
+ * yet. When the table is full, it is flushed first and refilled with the start
+ * state, so the new state may be the second one.
+ */
+int myLexicalAnalyzer::dfa_add_state(LazyDfa *dfa, const NodeSet &S) {
+  int token = dfa_accepts(dfa, S);
+
+  if (static_cast<int>(dfa->states.size()) == DFA_MAX_STATES) {
+    dfa->state_index.clear();
+    dfa->states.clear();
+    dfa->token.clear();
+    dfa->next.clear();
+    dfa_add_state(dfa, dfa->start);
+    if (S == dfa->start) return 0;
   }
 
-  bool changed = true;
-  std::set<RegularExpressionNode> S2;
+  int state = static_cast<int>(dfa->states.size());
+  dfa->state_index[S] = state;
+  dfa->states.push_back(S);
+  dfa->token.push_back(token);
+  dfa->next.resize(dfa->next.size() + DFA_ALPHABET, DFA_UNKNOWN);
+  return state;
+}
+
+/*
+ * Transition of a DFA state on c, worked out with match_one_char() and cached
+ * the first time it is taken.
+ */
+int myLexicalAnalyzer::dfa_next(LazyDfa *dfa, int state, char c) {
+  int slot = state * DFA_ALPHABET + static_cast<unsigned char>(c);
+  if (dfa->next[slot] != DFA_UNKNOWN) return dfa->next[slot];
 
-  while (changed) {
-    changed = false;
+  NodeSet S = match_one_char(dfa->states[state], c);
+  if (std::count(S.begin(), S.end(), 0) == static_cast<int>(S.size())) {
+    return dfa->next[slot] = DFA_DEAD;
+  }
 
-    for (it = S1.begin(); it != S1.end(); ++it) {
-      S2.insert(*it);
-      std::set<RegularExpressionNode>::iterator ik;
+  std::map<NodeSet, int>::iterator found = dfa->state_index.find(S);
+  if (found != dfa->state_index.end()) return dfa->next[slot] = found->second;
 
-      if (it->first_label == '_' && !check_node(S2, it->first_neighbor)) {
-        S2.insert(*it->first_neighbor);
-        std::set<RegularExpressionNode>::iterator ik;
+  int size = static_cast<int>(dfa->states.size());
+  int target = dfa_add_state(dfa, S);
+  // A flush renumbers the states and drops the row of this one
+  if (static_cast<int>(dfa->states.size()) > size) dfa->next[slot] = target;
+  return target;
+}
+
+/*
+ * Returns the length of the longest prefix of input, starting at position,
+ * that the DFA accepts, and sets token to the token it is accepted as. The
+ * length is 0 if there is no such prefix.
+ *
+ * After the DFA has warmed up every character costs one table lookup, and the
+ * scan stops as soon as no NFA node is left.
+ */
+int myLexicalAnalyzer::dfa_match(LazyDfa *dfa, const std::string &input,
+                                 int position, int *token) {
+  int state = 0;
+  int m = 0;
+  *token = -1;
+  for (int i = position; i < static_cast<int>(input.size()); i++) {
+    state = dfa_next(dfa, state, input[i]);
+    if (state == DFA_DEAD) break;
+    if (dfa->token[state] >= 0) {
+      m = i - position + 1;
+      *token = dfa->token[state];
+    }
+  }
+  return m;
+}
+
+/*
+ * Fills shapes from the graphs of the tokens: a token is nullable if its
+ * accept node is in the epsilon closure of its start node, its lexemes start
+ * with the labels of the edges that leave that closure, and it is a literal
+ * if its graph is a single path.
+ */
+void myLexicalAnalyzer::find_shapes() {
+  if (shapes.size() == tokens_list.size()) return;
+  if (closures.empty()) find_closures();
+  shapes.assign(tokens_list.size(), TokenShape());
+  for (size_t i = 0; i < tokens_list.size(); i++) {
+    const RegularExpressionGraph &reg = tokens_list[i].reg;
+    TokenShape &shape = shapes[i];
+    const Closure &closure = closures[reg.start];
+
+    shape.nullable = false;
+    for (size_t k = 0; k < closure.bits.size(); k++) {
+      for (uint64_t bits = closure.bits[k]; bits != 0; bits &= bits - 1) {
+        int node = (closure.first_word + k) * 64 + __builtin_ctzll(bits);
+        if (node == reg.accept) shape.nullable = true;
+        unsigned char labels[2] = {
+            static_cast<unsigned char>(arena.first_label[node]),
+            static_cast<unsigned char>(arena.second_label[node])};
+        int neighbors[2] = {arena.first_neighbor[node],
+                            arena.second_neighbor[node]};
+        for (int j = 0; j < 2; j++) {
+          if (labels[j] == CLASS_LABEL && neighbors[j] != 0) {
+            shape.first |= arena.class_sets[arena.first_class[node]];
+          } else if (labels[j] != '\0' && labels[j] != '_' &&
+                     neighbors[j] != 0) {
+            shape.first.set(labels[j]);
+          }
+        }
       }
+    }
 
-      if (it->second_label == '_' && !check_node(S2, it->second_neighbor)) {
-        S2.insert(*it->second_neighbor);
+    // A literal has one edge out of every node but the accept node
+    shape.is_literal = true;
+    for (int node = reg.start; node != reg.accept;
+         node = arena.first_neighbor[node]) {
+      if (arena.first_label[node] == '\0' || arena.first_neighbor[node] == 0 ||
+          arena.first_label[node] == CLASS_LABEL ||
+          arena.second_label[node] != '\0') {
+        shape.is_literal = false;
+        break;
+      }
+      if (arena.first_label[node] != '_') {
+        shape.literal += arena.first_label[node];
       }
     }
+    if (shape.literal.empty()) shape.is_literal = false;
+  }
+}
+
+/*
+ * Gets the lazy scan ready for when the DFA of all tokens is too big to
+ * compile. If some bytes can only start literal tokens, the literal tokens go
+ * into a trie, which is small enough to compile, so that lexemes starting
+ * with those bytes never touch the lazy DFA and do not add states to it.
+ * Returns the lazy DFA of all tokens for lazy_match().
+ */
+LazyDfa *myLexicalAnalyzer::split_literals() {
+  find_shapes();
+  std::vector<std::string> literals;
+  std::vector<int> tokens;
+  literal_first.reset();
+  other_first.reset();
+  for (size_t i = 0; i < shapes.size(); i++) {
+    if (shapes[i].is_literal) {
+      literals.push_back(shapes[i].literal);
+      tokens.push_back(i);
+      literal_first |= shapes[i].first;
+    } else {
+      other_first |= shapes[i].first;
+    }
+  }
 
-    if (!compare_set(S1, S2)) {
-      changed = true;
-      S1.insert(S2.begin(), S2.end());
-      S2.clear();
+  if ((literal_first & ~other_first).any()) {
+    Dfa trie = BuildTrie(literals, tokens);
+    literal_tables = Compress(trie);
+    literal_trie = literal_tables.view();
+    literal_split = true;
+    if (show_dfa_stats) {
+      std::cerr << "dfa: " << literals.size()
+                << " literal tokens in a trie of " << trie.size()
+                << " states, for " << (literal_first & ~other_first).count()
+                << " first bytes\n";
     }
   }
+  return dfa_for_all();
+}
 
-  return S1;
+/*
+ * dfa_match() for the lazy scan. After split_literals() a lexeme whose first
+ * byte starts no token but literals is matched in the trie instead.
+ */
+int myLexicalAnalyzer::lazy_match(LazyDfa *dfa, const std::string &input,
+                                  int position, int *token) {
+  unsigned char c = input[position];
+  if (!literal_split || other_first[c]) {
+    return dfa_match(dfa, input, position, token);
+  }
+  int max = literal_trie.Match(input.data() + position,
+                               input.data() + input.size(), token);
+  if (max == 0) *token = -1;
+  return max;
 }
 
 /*
- * Function definition for matching characters between the generated graph and
- * the input string. Generates a set of Regular Expression Graph IDs based on
- * the input character.
- *
- * Written by: Kaustubh Manoj Harapanahalli
+ * Builds the whole DFA of all tokens in tokens_list, the same one dfa_for_all()
+ * builds lazily, but over byte classes: every byte that labels an edge gets a
+ * class of its own, the other bytes share a class with the bytes that are in
+ * the same character classes, and the bytes in none share class 0, on which
+ * every state is dead. A class edge adds its target to every byte class in
+ * its character class, so [a-z] costs one class and one edge rather than 26
+ * of each. Returns false if the DFA would have more than max_states states.
  */
-int myLexicalAnalyzer::match(RegularExpressionGraph *reg, std::string input,
-                             int position) {
-  std::set<RegularExpressionNode> set_2;
-  set_2.insert(*reg->start);
-  std::set<RegularExpressionNode>::iterator it;
-  std::set<RegularExpressionNode> set_1;
-  set_1 = match_one_char(set_2, '_');
-  set_1.insert(set_2.begin(), set_2.end());
-  set_2.insert(set_1.begin(), set_1.end());
-
-  int size = 0;
-  int m = 0;
-  for (std::string::iterator it = input.begin() + position, end = input.end();
-       it != end; ++it) {
-    size++;
-    set_2 = match_one_char(set_2, *it);
-    std::set<RegularExpressionNode>::iterator ik;
+bool myLexicalAnalyzer::compile_dfa(Dfa *dfa, int max_states) {
+  LazyDfa *lazy = dfa_for_all();
+  std::memset(dfa->byte_class, 0, sizeof(dfa->byte_class));
+  dfa->classes = 1;
+  for (int node = 1; node < arena.size(); node++) {
+    unsigned char labels[2] = {
+        static_cast<unsigned char>(arena.first_label[node]),
+        static_cast<unsigned char>(arena.second_label[node])};
+    for (int j = 0; j < 2; j++) {
+      if (labels[j] != '\0' && labels[j] != CLASS_LABEL &&
+          dfa->byte_class[labels[j]] == 0) {
+        dfa->byte_class[labels[j]] = dfa->classes++;
+      }
+    }
+  }
+  std::map<std::vector<int>, int> in_sets;  // byte class by character classes
+  for (int c = 0; c < DFA_ALPHABET; c++) {
+    if (dfa->byte_class[c] != 0) continue;
+    std::vector<int> sets;
+    for (size_t i = 1; i < arena.class_sets.size(); i++) {
+      if (arena.class_sets[i].test(c)) sets.push_back(i);
+    }
+    if (sets.empty()) continue;
+    std::map<std::vector<int>, int>::iterator found = in_sets.find(sets);
+    if (found == in_sets.end()) {
+      found = in_sets.insert(std::make_pair(sets, dfa->classes++)).first;
+    }
+    dfa->byte_class[c] = found->second;
+  }
+  std::vector<std::vector<int> > set_classes(arena.class_sets.size());
+  for (size_t i = 1; i < arena.class_sets.size(); i++) {
+    std::vector<bool> seen(dfa->classes, false);
+    for (int c = 0; c < DFA_ALPHABET; c++) {
+      int k = dfa->byte_class[c];
+      if (arena.class_sets[i].test(c) && !seen[k]) {
+        seen[k] = true;
+        set_classes[i].push_back(k);
+      }
+    }
+  }
+
+  // The sets live in the map; states points at them in the order they were
+  // found, which is the order of the DFA states
+  std::map<NodeSet, int> index;
+  std::vector<const NodeSet *> states;
+  states.push_back(&index.insert(std::make_pair(lazy->start, 0)).first->first);
+  dfa->next.clear();
+  dfa->token.clear();
+  std::vector<NodeSet> successors(dfa->classes);
+  for (size_t s = 0; s < states.size(); s++) {
+    dfa->token.push_back(dfa_accepts(lazy, *states[s]));
+    dfa->next.push_back(DFA_DEAD);
+
+    // The same as match_one_char() on every class at once: each edge is
+    // looked at once and adds its target to the set of its class
+    const NodeSet &from = *states[s];
+    for (int k = 1; k < dfa->classes; k++) {
+      successors[k].assign(from.size(), 0);
+    }
+    for (size_t w = 0; w < from.size(); w++) {
+      for (uint64_t bits = from[w]; bits != 0; bits &= bits - 1) {
+        int node = w * 64 + __builtin_ctzll(bits);
+        unsigned char f = arena.first_label[node];
+        if (f == CLASS_LABEL && arena.first_neighbor[node] != 0) {
+          const std::vector<int> &to = set_classes[arena.first_class[node]];
+          for (size_t i = 0; i < to.size(); i++) {
+            add_closure(&successors[to[i]], arena.first_neighbor[node]);
+          }
+        } else if (f != '\0' && arena.first_neighbor[node] != 0) {
+          add_closure(&successors[dfa->byte_class[f]],
+                      arena.first_neighbor[node]);
+        }
+        unsigned char s = arena.second_label[node];
+        if (s != '\0' && arena.second_neighbor[node] != 0) {
+          add_closure(&successors[dfa->byte_class[s]],
+                      arena.second_neighbor[node]);
+        }
+      }
+    }
 
-    if (set_2.find(*reg->accept) != set_2.end()) {
-      m = size;
+    for (int k = 1; k < dfa->classes; k++) {
+      const NodeSet &S = successors[k];
+      if (std::count(S.begin(), S.end(), 0) == static_cast<int>(S.size())) {
+        dfa->next.push_back(DFA_DEAD);
+        continue;
+      }
+      std::map<NodeSet, int>::iterator found = index.find(S);
+      if (found == index.end()) {
+        if (static_cast<int>(states.size()) == max_states) return false;
+        found = index.insert(std::make_pair(S, states.size())).first;
+        states.push_back(&found->first);
+      }
+      dfa->next.push_back(found->second);
     }
   }
+  return true;
+}
 
-  return m;
+/*
+ * Function definition for matching characters between the generated graph and
+ * the input string. Returns the length of the longest prefix of the input,
+ * starting at position, that the token matches, 0 if there is none.
+ *
+ * Written by: Kaustubh Manoj Harapanahalli
+ */
+int myLexicalAnalyzer::match(const RegularExpressionGraph &reg,
+                             std::string input, int position) {
+  int token;
+  return dfa_match(dfa_for(reg), input, position, &token);
 }
 
 /*
@@ -457,37 +945,29 @@ int myLexicalAnalyzer::match(RegularExpressionGraph *reg, std::string input,
  * Written by: Kaustubh Manoj Harapanahalli
  */
 void myLexicalAnalyzer::check_epsilon() {
-  int start = 0;
-  std::vector<tokenReg>::iterator it;
-  std::string lex = "";
-  std::vector<std::string> splits = split("_", ' ');
+  std::string lex = epsilon_tokens();
 
-  for (int i = 0; i < splits.size(); i++) {
-    start = 0;
-
-    while (start != splits[i].size()) {
-      std::vector<tokenReg> tokens = get_tokens_list();
-
-      for (it = tokens.begin(); it != tokens.end(); ++it) {
-        tokenReg &reg = *it;
-        int lex_size = match(reg.reg, splits[i], start);
-
-        if (lex_size > 0) {
-          lex.append(" ");
-          lex.append(reg.token_name);
-        }
-      }
-
-      if (!lex.empty()) {
-        std::cout << "EPSILON IS NOOOOOOOT A TOKEN !!!" << lex << std::endl;
-        exit(1);
-      }
+  if (!lex.empty()) {
+    out << "EPSILON IS NOOOOOOOT A TOKEN !!!" << lex << std::endl;
+    Exit(1);
+  }
+}
 
-      if (lex.empty()) {
-        return;
-      }
+/*
+ * Returns the names of the tokens that match epsilon, each preceded by a
+ * space, or an empty string if there are none. The shapes of the tokens tell
+ * without matching every token on its own.
+ */
+std::string myLexicalAnalyzer::epsilon_tokens() {
+  std::string lex = "";
+  find_shapes();
+  for (size_t i = 0; i < tokens_list.size(); i++) {
+    if (shapes[i].nullable) {
+      lex.append(" ");
+      lex.append(tokens_list[i].token_name);
     }
   }
+  return lex;
 }
 
 /*
@@ -498,42 +978,381 @@ void myLexicalAnalyzer::check_epsilon() {
  * Written by: Kaustubh Manoj Harapanahalli
  */
 void myLexicalAnalyzer::my_get_token() {
-  int start = 0;
-  std::vector<tokenReg>::iterator it;
-  std::string lex = "";
   std::vector<std::string> splits = split(input_string, ' ');
 
-  check_epsilon();
+  // One scan of the DFA of all tokens finds the longest match; of the tokens
+  // that match that much, the one declared first wins
+  DfaTables tables;
+  DfaView view;
+  LazyDfa *dfa = prepare_scan(&tables, &view);
+
+  if (token_writer != NULL) {
+    write_tokens(view, dfa, splits);
+  } else if (dfa == NULL && scan_jobs != 1 &&
+             splits.size() >= 2 * SCAN_TASK_WORDS) {
+    scan_parallel(view, splits);
+  } else {
+    scan_words(view, dfa, splits, 0, splits.size(), out, NULL, cache_for(dfa));
+  }
+  print_cache_stats(cache_for(dfa));
+}
 
-  for (int i = 0; i < splits.size(); i++) {
-    start = 0;
+/*
+ * Writes the tokens of the words to the token file instead of printing them,
+ * SCAN_TASK_WORDS words at a time, or on the thread pool like my_get_token().
+ */
+void myLexicalAnalyzer::write_tokens(const DfaView &view, LazyDfa *dfa,
+                                     const std::vector<std::string> &words) {
+  token_writer->Start(token_names());
+  word_offsets.clear();
+  uint64_t offset = text_offset;
+  for (size_t i = 0; i < words.size(); i++) {
+    word_offsets.push_back(offset);
+    offset += words[i].size() + 1;  // and the space after it
+  }
 
-    while (start != splits[i].size()) {
-      int max = 0;
-      std::vector<tokenReg> tokens = get_tokens_list();
+  if (dfa == NULL && scan_jobs != 1 && words.size() >= 2 * SCAN_TASK_WORDS) {
+    scan_parallel(view, words);
+    return;
+  }
+  TokenRecords records;
+  for (size_t begin = 0; begin < words.size(); begin += SCAN_TASK_WORDS) {
+    size_t end = std::min(begin + SCAN_TASK_WORDS, words.size());
+    bool matched =
+        scan_words(view, dfa, words, begin, end, out, &records, cache_for(dfa));
+    token_writer->Append(records);
+    records.clear();
+    if (!matched) return;
+  }
+}
 
-      for (it = tokens.begin(); it != tokens.end(); ++it) {
-        tokenReg &reg = *it;
-        int lex_size = match(reg.reg, splits[i], start);
+/*
+ * Like my_get_token(), but for the words of a text that is read while it is
+ * tokenized, so tokens are printed before the rest of the text has been seen.
+ * Returns false if the text turns out not to be well formed.
+ */
+bool myLexicalAnalyzer::my_get_token_stream(TextStream *text) {
+  // An epsilon error is only reported for a well formed text
+  if (table_file == NULL && !epsilon_tokens().empty() && !text->Validate()) {
+    return false;
+  }
 
-        if (lex_size > max) {
-          max = lex_size;
-          lex = reg.token_name;
-        }
+  DfaTables tables;
+  DfaView view;
+  LazyDfa *dfa = prepare_scan(&tables, &view);
+  if (token_writer != NULL) token_writer->Start(token_names());
+
+  WordCache *cache = cache_for(dfa);
+  WordTokens scratch;
+  const char *word;
+  const char *word_end;
+  while (text->NextWord(&word, &word_end)) {
+    const WordTokens *tokens =
+        word_tokens(view, dfa, word, word_end - word, cache, &scratch);
+
+    const char *p = word;
+    for (size_t k = 0; k < tokens->token.size(); k++) {
+      int max = tokens->length[k];
+      if (token_writer != NULL) {
+        token_writer->Add(tokens->token[k], text->Offset(p), max);
+      } else {
+        out << token_name(tokens->token[k]) << " , \"";
+        out.write(p, max);
+        out << "\"\n";
       }
-
-      if (max == 0) {
-        std::cout << "ERROR";
-        return;
+      p += max;
+    }
+    if (tokens->error) {
+      if (token_writer != NULL) {
+        token_writer->Add(-1, text->Offset(p), 0);
+      } else {
+        out << "ERROR";
       }
+      print_cache_stats(cache);
+      return true;
+    }
+  }
+  print_cache_stats(cache);
+  return !text->error();
+}
 
-      std::cout << lex << " , \"" << splits[i].substr(start, max) << "\""
-                << std::endl;
+/*
+ * Gets the DFA of all tokens ready for scanning: the tables of the table file,
+ * or tables compiled from the token section after the epsilon check, which
+ * also writes the outputs of --compile and --generate. Returns the lazy DFA
+ * if the tables would be too big, NULL if view holds the tables. A table
+ * file has been checked for epsilon when it was written.
+ */
+LazyDfa *myLexicalAnalyzer::prepare_scan(DfaTables *tables, DfaView *view) {
+  if (table_file != NULL) {
+    *view = table_file->dfa();
+    return NULL;
+  }
+  check_epsilon();
+  if (save_tables_path != NULL || scanner_path != NULL) write_compiled();
+  Dfa minimal;
+  if (!compile_tables(DFA_COMPILE_MAX_STATES, &minimal, tables)) {
+    return split_literals();
+  }
+  *view = tables->view();
+  return NULL;
+}
+
+/*
+ * Prints the tokens of words[begin, end) to to, matched with the compiled
+ * tables in view or, if dfa is not NULL, with the lazy DFA. Returns false if
+ * some word has no token at some point; the output then ends with ERROR.
+ * If records is not NULL, the tokens are added to it instead, with their
+ * offsets in word_offsets, and the ERROR is a record of token -1. Words seen
+ * before are looked up in cache, unless it is NULL.
+ */
+bool myLexicalAnalyzer::scan_words(const DfaView &view, LazyDfa *dfa,
+                                   const std::vector<std::string> &words,
+                                   size_t begin, size_t end, std::ostream &to,
+                                   TokenRecords *records, WordCache *cache) {
+  if (dfa == NULL && scan_lanes > 1) {
+    return scan_words_interleaved(view, words, begin, end, to, records);
+  }
+  WordTokens scratch;
+  for (size_t i = begin; i < end; i++) {
+    const std::string &word = words[i];
+    const WordTokens *tokens =
+        word_tokens(view, dfa, word.data(), word.size(), cache, &scratch);
+
+    size_t start = 0;
+    for (size_t k = 0; k < tokens->token.size(); k++) {
+      int max = tokens->length[k];
+      if (records != NULL) {
+        records->Add(tokens->token[k], word_offsets[i] + start, max);
+      } else {
+        to << token_name(tokens->token[k]) << " , \"";
+        to.write(word.data() + start, max);
+        to << "\"\n";
+      }
       start += max;
     }
+    if (tokens->error) {
+      if (records != NULL) {
+        records->Add(-1, word_offsets[i] + start, 0);
+      } else {
+        to << "ERROR";
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * Returns the tokens of [word, word + size) from cache or, on a miss, matches
+ * them with the compiled tables in view or, if dfa is not NULL, with the lazy
+ * DFA, and caches them. Words that are not cached are matched into scratch.
+ * cache may be NULL.
+ */
+const WordTokens *myLexicalAnalyzer::word_tokens(const DfaView &view,
+                                                 LazyDfa *dfa,
+                                                 const char *word,
+                                                 size_t size,
+                                                 WordCache *cache,
+                                                 WordTokens *scratch) {
+  bool hit = false;
+  WordTokens *tokens =
+      cache != NULL ? cache->Lookup(word, size, &hit) : NULL;
+  if (hit) return tokens;
+  if (tokens == NULL) tokens = scratch;
+  tokens->clear();
+
+  std::string copy;  // of the word, for the lazy DFA
+  if (dfa != NULL) copy.assign(word, size);
+  for (size_t start = 0; start < size;) {
+    int token;
+    int max = dfa == NULL ? view.Match(word + start, word + size, &token)
+                          : lazy_match(dfa, copy, start, &token);
+    if (max == 0) {
+      tokens->error = true;
+      break;
+    }
+    tokens->Add(token, max);
+    start += max;
+  }
+  return tokens;
+}
+
+/*
+ * The word cache for a scan with the lazy DFA, or with the compiled tables in
+ * view if dfa is NULL. A table lookup per byte costs about as much as hashing
+ * and comparing the word, so with tables the cache only pays off for texts
+ * that repeat few words very often, and is used only if its size was set.
+ */
+WordCache *myLexicalAnalyzer::cache_for(LazyDfa *dfa) {
+  return dfa != NULL || word_cache_slots >= 0 ? &word_cache : NULL;
+}
+
+// Prints the hits and misses of cache to std::cerr if asked to
+void myLexicalAnalyzer::print_cache_stats(const WordCache *cache) const {
+  if (!show_cache_stats) return;
+  if (cache == NULL) {
+    std::cerr << "word cache: not used\n";
+    return;
+  }
+  std::cerr << "word cache: " << cache->slots() << " slots, " << cache->hits()
+            << " hits, " << cache->misses() << " misses\n";
+}
+
+/*
+ * Like scan_words() with compiled tables, but walks scan_lanes words through
+ * the tables at once with DfaView::Tokenize(), SCAN_TASK_WORDS words at a
+ * time so the found tokens take bounded memory.
+ */
+bool myLexicalAnalyzer::scan_words_interleaved(
+    const DfaView &view, const std::vector<std::string> &words, size_t begin,
+    size_t end, std::ostream &to, TokenRecords *records) {
+  std::vector<const char *> word_begin;
+  std::vector<const char *> word_end;
+  std::vector<DfaToken> tokens;
+  for (size_t block = begin; block < end; block += SCAN_TASK_WORDS) {
+    size_t block_end = std::min(block + SCAN_TASK_WORDS, end);
+    word_begin.clear();
+    word_end.clear();
+    for (size_t i = block; i < block_end; i++) {
+      word_begin.push_back(words[i].data());
+      word_end.push_back(words[i].data() + words[i].size());
+    }
+    tokens.clear();
+    view.Tokenize(word_begin.data(), word_end.data(), word_begin.size(),
+                  scan_lanes, &tokens);
+
+    for (size_t t = 0; t < tokens.size(); t++) {
+      const DfaToken &found = tokens[t];
+      size_t i = block + found.input;
+      if (records != NULL) {
+        records->Add(found.token, word_offsets[i] + found.offset,
+                     found.length);
+        if (found.token < 0) return false;
+        continue;
+      }
+      if (found.token < 0) {
+        to << "ERROR";
+        return false;
+      }
+      to << token_name(found.token) << " , \"";
+      to.write(words[i].data() + found.offset, found.length);
+      to << "\"\n";
+    }
+  }
+  return true;
+}
+
+/*
+ * Scans the words on scan_jobs threads. Each task tokenizes a run of
+ * SCAN_TASK_WORDS words into a buffer of its own and only reads the tables,
+ * which all tasks share. The buffers are printed, or written to the token
+ * file, in order up to and including the first one that ends in ERROR, so the
+ * output is the same as a scan on one thread; tasks after that one are
+ * skipped if they have not started yet.
+ */
+void myLexicalAnalyzer::scan_parallel(const DfaView &view,
+                                      const std::vector<std::string> &words) {
+  int tasks = (words.size() + SCAN_TASK_WORDS - 1) / SCAN_TASK_WORDS;
+  std::vector<std::ostringstream> buffers(tasks);
+  std::vector<TokenRecords> records(token_writer != NULL ? tasks : 0);
+  std::vector<char> failed(tasks, 0);
+  std::atomic<int> first_failed(tasks);
+  {
+    ThreadPool pool(scan_jobs);
+    for (int t = 0; t < tasks; t++) {
+      pool.Submit([this, t, &view, &words, &buffers, &records, &failed,
+                   &first_failed] {
+        if (t > first_failed.load()) return;
+        size_t begin = static_cast<size_t>(t) * SCAN_TASK_WORDS;
+        size_t end = std::min(begin + SCAN_TASK_WORDS, words.size());
+        if (!scan_words(view, NULL, words, begin, end, buffers[t],
+                        records.empty() ? NULL : &records[t], NULL)) {
+          failed[t] = 1;
+          int seen = first_failed.load();
+          while (t < seen && !first_failed.compare_exchange_weak(seen, t)) {
+          }
+        }
+      });
+    }
+    pool.Wait();
+  }
+
+  for (int t = 0; t < tasks; t++) {
+    if (token_writer != NULL) {
+      token_writer->Append(records[t]);
+    } else {
+      out << buffers[t].str();
+    }
+    if (failed[t]) return;
   }
 }
 
+/*
+ * Builds the minimal DFA of all tokens and its comb vector tables, if the DFA
+ * has at most max_states states, and prints their sizes if asked to.
+ */
+bool myLexicalAnalyzer::compile_tables(int max_states, Dfa *minimal,
+                                       DfaTables *tables) {
+  Dfa subset;
+  if (!compile_dfa(&subset, max_states)) {
+    if (show_dfa_stats) {
+      std::cerr << "dfa: more than " << max_states
+                << " states, scanning with the lazy DFA\n";
+    }
+    return false;
+  }
+  *minimal = Minimize(subset);
+  *tables = Compress(*minimal);
+  if (show_dfa_stats) {
+    std::ostringstream stats;
+    PrintDfaStats(stats, tokens_list.size(), subset, *minimal, *tables);
+    std::cerr << stats.str();
+  }
+  return true;
+}
+
+/*
+ * Writes the DFA of the token section to the table file (see tables.h) and
+ * the scanner source (see codegen.h) asked for with --compile and
+ * --generate.
+ */
+void myLexicalAnalyzer::write_compiled() {
+  Dfa minimal;
+  DfaTables tables;
+  std::string error;
+  if (!compile_tables(DFA_FILE_MAX_STATES, &minimal, &tables)) {
+    error = "the DFA has more than " + std::to_string(DFA_FILE_MAX_STATES) +
+            " states";
+  } else {
+    std::vector<std::string> names = token_names();
+    if ((save_tables_path == NULL ||
+         WriteTableFile(save_tables_path, tables, names, &error)) &&
+        (scanner_path == NULL ||
+         WriteScanner(scanner_path, minimal, names, &error))) {
+      return;
+    }
+  }
+  out << "Error: " << error << std::endl;
+  Exit(1);
+}
+
+/*
+ * Name of a token, from the token section or from the table file.
+ */
+std::string myLexicalAnalyzer::token_name(int token) const {
+  if (table_file != NULL) return table_file->token_name(token);
+  return tokens_list[token].token_name;
+}
+
+// The names of all tokens in declaration order
+std::vector<std::string> myLexicalAnalyzer::token_names() const {
+  int tokens = table_file != NULL ? table_file->tokens() : tokens_list.size();
+  std::vector<std::string> names;
+  for (int i = 0; i < tokens; i++) names.push_back(token_name(i));
+  return names;
+}
+
 /*
  * Function to relate the input string provided in the input data to the
  * function - myLexicalAnalyzer for executing lexical analysis after syntax and
@@ -541,8 +1360,10 @@ void myLexicalAnalyzer::my_get_token() {
  *
  * Written by: Kaustubh Manoj Harapanahalli
  */
-void myLexicalAnalyzer::set_input_string(const std::string &input_string) {
+void myLexicalAnalyzer::set_input_string(const std::string &input_string,
+                                         size_t offset) {
   myLexicalAnalyzer::input_string = input_string;
+  text_offset = offset;
 }
 
 /*
@@ -582,88 +1403,214 @@ std::vector<std::string> myLexicalAnalyzer::split(std::string s, char delimit) {
   return temp;
 }
 
-int myLexicalAnalyzer::counter;
+myLexicalAnalyzer::myLexicalAnalyzer(std::ostream &out)
+    : text_offset(0),
+      out(out),
+      word_cache(word_cache_slots < 0 ? WORD_CACHE_SLOTS : word_cache_slots),
+      literal_split(false) {}
+
+bool myLexicalAnalyzer::show_dfa_stats = false;
+int myLexicalAnalyzer::scan_jobs = 1;
+int myLexicalAnalyzer::scan_lanes = 1;
+int myLexicalAnalyzer::word_cache_slots = -1;
+bool myLexicalAnalyzer::show_cache_stats = false;
+const char *myLexicalAnalyzer::save_tables_path = NULL;
+const char *myLexicalAnalyzer::scanner_path = NULL;
+const TableFile *myLexicalAnalyzer::table_file = NULL;
+TokenWriter *myLexicalAnalyzer::token_writer = NULL;
+
+void myLexicalAnalyzer::SetShowDfaStats(bool show) { show_dfa_stats = show; }
+
+void myLexicalAnalyzer::SetSaveTables(const char *path) {
+  save_tables_path = path;
+}
 
-/*
- * Counter to track the number of Regular expression nodes that are present in
- * the selected regular expression graph for easier assignment and tracking of
- * regular expression graph node tracking.
- *
- * Written by: Kaustubh Manoj Harapanahalli
- */
-int myLexicalAnalyzer::get_counter() const {
-  counter++;
-  return counter;
+void myLexicalAnalyzer::SetScanJobs(int jobs) { scan_jobs = jobs; }
+
+void myLexicalAnalyzer::SetScanLanes(int lanes) { scan_lanes = lanes; }
+
+void myLexicalAnalyzer::SetWordCache(int slots) { word_cache_slots = slots; }
+
+void myLexicalAnalyzer::SetShowCacheStats(bool show) {
+  show_cache_stats = show;
+}
+
+void myLexicalAnalyzer::SetGenerateScanner(const char *path) {
+  scanner_path = path;
+}
+
+void myLexicalAnalyzer::SetTableFile(const TableFile *file) {
+  table_file = file;
+}
+
+void myLexicalAnalyzer::SetTokenWriter(TokenWriter *writer) {
+  token_writer = writer;
 }
 
 /*
- * Simplified function to set the counter value to a variable related to the
- * class.
+ * The arena that holds the nodes of the regular expression graphs of all
+ * tokens. parse_expr() adds the nodes of each token to it.
  *
  * Written by: Kaustubh Manoj Harapanahalli
  */
-void myLexicalAnalyzer::set_counter(int count) { counter = count; }
+RegularExpressionArena *myLexicalAnalyzer::get_arena() { return &arena; }
 
 /*
- * Function to compare two input nodes, one obtained from set of of tokens and
- * the other from the token description input.
+ * Usage: ./a.out [--stream] [--batch] [--jobs N] [--scan-jobs N]
+ *                [--lanes N] [--word-cache N] [--cache-stats]
+ *                [--stream-text] [--dfa-stats] [--compile FILE]
+ *                [--generate FILE] [--tables FILE] [--binary FILE] < input
  *
- * Written by: Kaustubh Manoj Harapanahalli
+ * --stream     scan tokens on demand instead of tokenizing the whole input
+ *              before parsing starts
+ * --batch      run every program of a batch (see batch.h)
+ * --jobs N     run a batch N programs at a time, one per core if N is 0
+ *              (implies --batch)
+ * --scan-jobs N
+ *              tokenize the words of a long input text on N threads, one
+ *              per core if N is 0
+ * --lanes N    walk up to N (at most 16) words through the compiled token
+ *              tables at once, which pays off when the tables do not fit in
+ *              the cache (see DfaView::Tokenize() and bench/dfa_bench.cc)
+ * --word-cache N
+ *              keep the tokens of up to N (rounded up to a power of two)
+ *              recently seen words, 0 for none; by default 4096 words, and
+ *              only when the token DFA is too big to compile; the scan jobs
+ *              of --scan-jobs and --lanes do not use the cache (see
+ *              wordcache.h)
+ * --cache-stats
+ *              print the hits and misses of the word cache to standard error
+ * --stream-text
+ *              read the input text in chunks and tokenize it while it is
+ *              read, in bounded memory (see textstream.h); not with --batch
+ * --dfa-stats  print the state counts and table sizes of the token DFA to
+ *              standard error
+ * --compile FILE
+ *              also write the DFA of the token section to the table file FILE
+ * --generate FILE
+ *              also write a C++ scanner for the tokens of the token section
+ *              to FILE (see codegen.h)
+ * --tables FILE
+ *              take the tokens from the table file FILE; the input then holds
+ *              only the quoted input text
+ * --binary FILE
+ *              write the tokens to the token file FILE (see tokenfile.h)
+ *              instead of printing them; not with --batch
  */
-bool myLexicalAnalyzer::check_node(std::set<RegularExpressionNode> S,
-                                   RegularExpressionNode *r) {
-  std::set<RegularExpressionNode>::iterator i;
-  for (i = S.begin(); i != S.end(); ++i) {
-    if (r->reg_id == i->reg_id) {
-      return true;
-    }
-  }
-  return false;
+static void parse_and_run(std::ostream &out) {
+  Parser parser(out);
+  parser.parseInput();
 }
 
-/*
- * Function to compare if two input sets have the same values.
- *
- * Written by: Kaustubh Manoj Harapanahalli
- */
-bool myLexicalAnalyzer::compare_set(std::set<RegularExpressionNode> S1,
-                                    std::set<RegularExpressionNode> S2) {
-  if (S1.size() != S2.size()) {
-    return false;
-  }
+static void scan_and_run(std::ostream &out) {
+  Parser parser(out);
+  parser.parseInputText();
+}
 
-  std::set<RegularExpressionNode>::iterator i;
-  int s1[S1.size()];
-  int s2[S2.size()];
-  int j = 0, k = 0;
+static void stream_and_run(std::ostream &out) {
+  Parser parser(out);
+  parser.parseStreamedInput();
+}
 
-  for (i = S1.begin(); i != S1.end(); ++i) {
-    s1[j] = i->reg_id;
-    j++;
+static void stream_text_and_run(std::ostream &out) {
+  Parser parser(out);
+  parser.parseStreamedInputText();
+}
+
+int main(int argc, char *argv[]) {
+  bool batch = false;
+  int jobs = 1;
+  bool stream_text = false;
+  const char *tables_path = NULL;
+  const char *binary_path = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    std::string option = argv[i];
+    if (option == "--stream") {
+      LexicalAnalyzer::SetMode(STREAMING);
+    } else if (option == "--batch") {
+      batch = true;
+    } else if (option == "--jobs" && i + 1 < argc) {
+      batch = true;
+      jobs = atoi(argv[++i]);
+    } else if (option == "--scan-jobs" && i + 1 < argc) {
+      myLexicalAnalyzer::SetScanJobs(atoi(argv[++i]));
+    } else if (option == "--lanes" && i + 1 < argc) {
+      myLexicalAnalyzer::SetScanLanes(atoi(argv[++i]));
+    } else if (option == "--word-cache" && i + 1 < argc) {
+      myLexicalAnalyzer::SetWordCache(atoi(argv[++i]));
+    } else if (option == "--cache-stats") {
+      myLexicalAnalyzer::SetShowCacheStats(true);
+    } else if (option == "--stream-text") {
+      stream_text = true;
+    } else if (option == "--dfa-stats") {
+      myLexicalAnalyzer::SetShowDfaStats(true);
+    } else if (option == "--compile" && i + 1 < argc) {
+      myLexicalAnalyzer::SetSaveTables(argv[++i]);
+    } else if (option == "--generate" && i + 1 < argc) {
+      myLexicalAnalyzer::SetGenerateScanner(argv[++i]);
+    } else if (option == "--tables" && i + 1 < argc) {
+      tables_path = argv[++i];
+    } else if (option == "--binary" && i + 1 < argc) {
+      binary_path = argv[++i];
+    } else {
+      std::cout << "Error: unrecognized option " << option << std::endl;
+      return 1;
+    }
   }
-  std::set<RegularExpressionNode>::iterator t;
 
-  for (i = S2.begin(); i != S2.end(); ++i) {
-    s2[k] = i->reg_id;
-    k++;
+  // The table file is mapped once and shared by all programs of a batch
+  TableFile table_file;
+  void (*run)(std::ostream &) = parse_and_run;
+  if (tables_path != NULL) {
+    std::string error;
+    if (!table_file.Open(tables_path, &error)) {
+      std::cout << "Error: " << error << std::endl;
+      return 1;
+    }
+    myLexicalAnalyzer::SetTableFile(&table_file);
+    run = scan_and_run;
   }
 
-  std::sort(s1, s1 + j);
-  std::sort(s2, s2 + k);
+  // The lexer reads standard input only up to the HASH, and the input text
+  // is read from there on by a TextStream
+  if (stream_text) {
+    if (batch) {
+      std::cout << "Error: --stream-text does not work with --batch"
+                << std::endl;
+      return 1;
+    }
+    LexicalAnalyzer::SetMode(STREAMING);
+    InputBuffer::SetStopAfter('#');
+    run = tables_path != NULL ? stream_text_and_run : stream_and_run;
+  }
 
-  for (int m = 0; m < k; m++) {
-    if (s1[m] != s2[m]) {
-      return false;
+  // All programs of a batch would write to the same token file
+  TokenWriter token_writer;
+  if (binary_path != NULL) {
+    std::string error;
+    if (batch) {
+      std::cout << "Error: --binary does not work with --batch" << std::endl;
+      return 1;
+    }
+    if (!token_writer.Open(binary_path, &error)) {
+      std::cout << "Error: " << error << std::endl;
+      return 1;
     }
+    myLexicalAnalyzer::SetTokenWriter(&token_writer);
   }
 
-  return true;
-}
+  if (batch) {
+    RunBatch(run, jobs);
+    return 0;
+  }
+  run(std::cout);
 
-/*
- *
- */
-int main() {
-  Parser parser;
-  parser.parseInput();
+  if (binary_path != NULL) {
+    std::string error;
+    if (!token_writer.Finish(&error)) {
+      std::cout << "Error: " << error << std::endl;
+      return 1;
+    }
+  }
 }
@@ -6,95 +6,285 @@
 #ifndef PARSER_H_
 #define PARSER_H_
 
-#include <set>
+#include <stdint.h>
+
+#include <bitset>
+#include <map>
+#include <ostream>
 #include <string>
 #include <vector>
 
+#include "./dfa.h"
 #include "./lexer.h"
+#include "./tables.h"
+#include "./textstream.h"
+#include "./tokenfile.h"
+#include "./wordcache.h"
+
+// Label of an edge taken on any byte of a character class
+#define CLASS_LABEL '\x01'
+
+typedef std::bitset<DFA_ALPHABET> ByteSet;
 
 /*
- *Definition of RegularExpressionNode to generate the Non-definite Automata
- *Graph for the incoming input for each token
+ * Storage for the nodes of the Non-deterministic finite Automata Graphs of all
+ * tokens. The nodes are kept as parallel arrays indexed by reg_id, so a walk
+ * over the graph reads a few contiguous arrays and the whole graph is freed
+ * or copied in one go. A node has at most two outgoing edges; a missing edge
+ * has label '\0' and target 0. reg_id 0 is not a node.
+ *
+ * A character class like [a-z0-9] is a single first edge with label
+ * CLASS_LABEL, taken on every byte of class_sets[first_class[node]], rather
+ * than a tree of '|' nodes.
  *
  * Written by: Kaustubh Manoj Harapanahalli
  */
-typedef struct RegularExpressionNode {
-  RegularExpressionNode* first_neighbor;
-  char first_label;
-  RegularExpressionNode* second_neighbor;
-  char second_label;
-  int reg_id;
-
-  RegularExpressionNode() {
-    first_neighbor = NULL;
-    first_label = '\0';
-    second_neighbor = NULL;
-    second_label = '\0';
+typedef struct RegularExpressionArena {
+  std::vector<char> first_label;
+  std::vector<int> first_neighbor;
+  std::vector<char> second_label;
+  std::vector<int> second_neighbor;
+  std::vector<int> first_class;  // index into class_sets, or 0
+  std::vector<ByteSet> class_sets;
+
+  RegularExpressionArena() : class_sets(1) { add_node(); }
+
+  // Adds a node without edges and returns its reg_id
+  int add_node() {
+    first_label.push_back('\0');
+    first_neighbor.push_back(0);
+    second_label.push_back('\0');
+    second_neighbor.push_back(0);
+    first_class.push_back(0);
+    return static_cast<int>(first_label.size()) - 1;
+  }
+
+  // True if the edge of node with label label is taken on byte c
+  bool takes(int node, char label, char c) const {
+    if (label == CLASS_LABEL) {
+      return class_sets[first_class[node]].test(static_cast<unsigned char>(c));
+    }
+    return label == c;
   }
-} RegularExpressionNode;
+
+  int size() const { return static_cast<int>(first_label.size()); }
+} RegularExpressionArena;
 
 /*
  * Definition of RegularExpressionGraph to generate the Non-deterministic finite
- * Automata Graph for the incoming input for each token
+ * Automata Graph for the incoming input for each token. start and accept are
+ * reg_ids of nodes in the arena.
  *
  * Written by: Kaustubh Manoj Harapanahalli
  */
 typedef struct RegularExpressionGraph {
-  RegularExpressionNode* start;
-  RegularExpressionNode* accept;
+  int start;
+  int accept;
 } RegularExpressionGraph;
 
 typedef struct tokenReg {
   std::string token_name;
-  RegularExpressionGraph* reg;
+  RegularExpressionGraph reg;
 } tokenReg;
 
-static bool operator<(const RegularExpressionNode& n1,
-                      const RegularExpressionNode& n2) {
-  return n1.reg_id < n2.reg_id;
-}
+// ------- NFA node sets -------------------
+//
+// reg_ids are dense, so a set of NFA nodes is a bitset indexed by reg_id. The
+// epsilon closure of every node is worked out once, when matching starts. A
+// closure never leaves the token its node belongs to, and the nodes of a token
+// have consecutive reg_ids, so each closure only stores the words of the
+// bitset that cover its own nodes.
+
+typedef std::vector<uint64_t> NodeSet;
+
+typedef struct Closure {
+  int first_word;               // word of the NodeSet bits[0] stands for
+  std::vector<uint64_t> bits;
+} Closure;
+
+// ------- lazy DFA -------------------
+//
+// Tokens are matched with a DFA that is built from their NFAs while it is
+// being used. A DFA state stands for the set of NFA nodes the simulation can
+// be in. Its transition on a character is worked out with match_one_char()
+// the first time it is taken and read from a table of DFA_ALPHABET entries
+// per state after that. At most DFA_MAX_STATES states are kept per DFA: when
+// the table is full it is flushed and refilled from the state being matched,
+// so a pattern whose DFA would be huge costs time instead of memory.
+//
+// match() uses a DFA of one token. my_get_token() uses a single DFA for all
+// tokens, started from the union of their start closures, whose states are
+// tagged with the earliest declared token they accept. One scan then finds
+// the longest match of every token at once.
+//
+// Before my_get_token() scans, it tries to build that DFA completely, over
+// classes of bytes that no label tells apart, minimizes it and packs its
+// transitions into comb vector tables (see dfa.h). Token sets whose DFA has
+// more than DFA_COMPILE_MAX_STATES states are scanned with the lazy DFA.
+// Tables written to a table file or a generated scanner may have up to
+// DFA_FILE_MAX_STATES states, since they are built only once.
+
+#define DFA_MAX_STATES 1024
+#define DFA_COMPILE_MAX_STATES 4096
+#define DFA_FILE_MAX_STATES (1 << 20)
+
+// With more than one scan job, the words of the input text are tokenized in
+// tasks of SCAN_TASK_WORDS words on a thread pool. The lazy DFA changes as it
+// is used, so only compiled tables are shared that way.
+#define SCAN_TASK_WORDS 1024
+#define DFA_UNKNOWN -2  // transition not worked out yet
+
+typedef struct LazyDfa {
+  NodeSet start;
+  std::vector<int> token_of;  // by reg_id: token the node accepts, or -1
+  std::map<NodeSet, int> state_index;
+  std::vector<NodeSet> states;
+  std::vector<int> token;  // token accepted in each state, or -1
+  std::vector<int> next;   // DFA_ALPHABET entries per state
+} LazyDfa;
+
+// What the expression of a token looks like, read off its graph once without
+// building an automaton for it
+typedef struct TokenShape {
+  bool nullable;  // matches the empty string
+  ByteSet first;  // bytes its lexemes can start with
+  bool is_literal;                  // only CHARs and DOTs: one lexeme
+  std::string literal;              // that lexeme
+} TokenShape;
 
 class myLexicalAnalyzer {
  public:
+  explicit myLexicalAnalyzer(std::ostream& out);
   void my_get_token();
-  int match(RegularExpressionGraph* reg, std::string, int i);
-  std::set<RegularExpressionNode> match_one_char(
-      std::set<RegularExpressionNode> set1, char c);
-  void set_input_string(const std::string& input_string);
+  int match(const RegularExpressionGraph& reg, std::string, int i);
+  NodeSet match_one_char(const NodeSet& S, char c);
+  // offset: where input_string starts in the text between the quotes
+  void set_input_string(const std::string& input_string, size_t offset = 0);
   void set_tokens_list(const tokenReg& token);
   const std::vector<tokenReg>& get_tokens_list() const;
   std::vector<std::string> split(std::string str, char delimit);
-  int get_counter() const;
-  static void set_counter(int counter);
-  bool check_node(std::set<RegularExpressionNode> S, RegularExpressionNode* r);
-  bool compare_set(std::set<RegularExpressionNode> S1,
-                   std::set<RegularExpressionNode> S2);
+  RegularExpressionArena* get_arena();
   void check_epsilon();
+  bool my_get_token_stream(TextStream* text);
+
+  // Prints the sizes of the compiled DFA to std::cerr when it is built
+  static void SetShowDfaStats(bool show);
+  // Tokenizes long input texts on jobs threads (0: one per core)
+  static void SetScanJobs(int jobs);
+  // Walks up to lanes words through the compiled tables at once
+  static void SetScanLanes(int lanes);
+  // Caches the tokens of up to slots words (0: no cache), also with compiled
+  // tables
+  static void SetWordCache(int slots);
+  // Prints the hits and misses of the word cache to std::cerr
+  static void SetShowCacheStats(bool show);
+  // Writes the tables of the token section to path before scanning
+  static void SetSaveTables(const char* path);
+  // Writes a C++ scanner for the token section to path before scanning
+  static void SetGenerateScanner(const char* path);
+  // Scans with the tables of file instead of the token section
+  static void SetTableFile(const TableFile* file);
+  // Writes the tokens to writer instead of printing them
+  static void SetTokenWriter(TokenWriter* writer);
 
  private:
+  static bool show_dfa_stats;
+  static int scan_jobs;
+  static int scan_lanes;
+  static int word_cache_slots;
+  static bool show_cache_stats;
+  static const char* save_tables_path;
+  static const char* scanner_path;
+  static const TableFile* table_file;
+  static TokenWriter* token_writer;
   std::vector<tokenReg> tokens_list;
   std::string input_string;
-  static int counter;
+  size_t text_offset;
+  std::vector<uint64_t> word_offsets;  // in the text, by word, for tokens
+  std::ostream& out;
+  WordCache word_cache;
+  RegularExpressionArena arena;
+  std::vector<Closure> closures;  // by reg_id
+  void find_closures();
+  void add_closure(NodeSet* S, int reg_id);
+  std::map<int, LazyDfa> dfas;  // by start node
+  LazyDfa all_tokens;
+  std::vector<TokenShape> shapes;  // by token, once find_shapes() ran
+  // The literal tokens in a trie, used by the lazy scan for the bytes that
+  // only literal tokens start with
+  bool literal_split;
+  DfaTables literal_tables;
+  DfaView literal_trie;
+  ByteSet literal_first;
+  ByteSet other_first;
+  void dfa_add_token(LazyDfa* dfa, const RegularExpressionGraph& reg,
+                     int token);
+  LazyDfa* dfa_for(const RegularExpressionGraph& reg);
+  LazyDfa* dfa_for_all();
+  int dfa_accepts(const LazyDfa* dfa, const NodeSet& S);
+  int dfa_add_state(LazyDfa* dfa, const NodeSet& S);
+  int dfa_next(LazyDfa* dfa, int state, char c);
+  int dfa_match(LazyDfa* dfa, const std::string& input, int position,
+                int* token);
+  void find_shapes();
+  LazyDfa* split_literals();
+  int lazy_match(LazyDfa* dfa, const std::string& input, int position,
+                 int* token);
+  bool compile_dfa(Dfa* dfa, int max_states);
+  bool compile_tables(int max_states, Dfa* minimal, DfaTables* tables);
+  void write_compiled();
+  std::string token_name(int token) const;
+  std::vector<std::string> token_names() const;
+  std::string epsilon_tokens();
+  LazyDfa* prepare_scan(DfaTables* tables, DfaView* view);
+  bool scan_words(const DfaView& view, LazyDfa* dfa,
+                  const std::vector<std::string>& words, size_t begin,
+                  size_t end, std::ostream& to, TokenRecords* records,
+                  WordCache* cache);
+  const WordTokens* word_tokens(const DfaView& view, LazyDfa* dfa,
+                                const char* word, size_t size,
+                                WordCache* cache, WordTokens* scratch);
+  WordCache* cache_for(LazyDfa* dfa);
+  void print_cache_stats(const WordCache* cache) const;
+  bool scan_words_interleaved(const DfaView& view,
+                              const std::vector<std::string>& words,
+                              size_t begin, size_t end, std::ostream& to,
+                              TokenRecords* records);
+  void scan_parallel(const DfaView& view,
+                     const std::vector<std::string>& words);
+  void write_tokens(const DfaView& view, LazyDfa* dfa,
+                    const std::vector<std::string>& words);
 };
 
 class Parser {
  public:
+  explicit Parser(std::ostream& out);
   void parseInput();
+  void parseInputText();
+  void parseStreamedInput();
+  void parseStreamedInputText();
   void parse_input();
   void readAndPrintAllInput();
 
  private:
+  std::ostream& out;
   LexicalAnalyzer lexer;
   myLexicalAnalyzer my_lexer;
+  // Token ids seen so far and the semantic errors they raised
+  std::vector<Token> track_token;
+  std::vector<std::string> track_semantic_error_messages;
   void syntax_error();
   void expression_syntax_error(Token token_id);
   void semantic_error();
   Token expect_expr(TokenType expected_type, Token token_id);
   Token expect(TokenType expected_type);
+  void parse_input_text();
+  void scan_streamed_text(TextStream* text);
   void parse_tokens_section();
   void parse_token_list();
   void parse_token();
-  struct RegularExpressionGraph* parse_expr(Token token_id);
+  struct RegularExpressionGraph parse_expr(Token token_id);
+  bool parse_class(const Token& token, ByteSet* set);
 };
 
 #endif  // PARSER_H_
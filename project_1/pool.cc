@@ -0,0 +1,93 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Work-stealing thread pool.
+ */
+#include "./pool.h"
+
+#include <utility>
+
+ThreadPool::ThreadPool(int threads)
+    : queued_(0), unfinished_(0), next_(0), stopping_(false) {
+  if (threads <= 0) threads = std::thread::hardware_concurrency();
+  if (threads <= 0) threads = 1;
+  for (int i = 0; i < threads; i++) {
+    queues_.push_back(std::unique_ptr<Queue>(new Queue));
+  }
+  for (int i = 0; i < threads; i++) {
+    workers_.push_back(std::thread(&ThreadPool::Work, this, i));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    stopping_ = true;
+  }
+  work_ready_.notify_all();
+  for (size_t i = 0; i < workers_.size(); i++) workers_[i].join();
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+  Queue* queue;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    queue = queues_[next_++ % queues_.size()].get();
+    unfinished_++;
+  }
+  {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    queue->tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    queued_++;
+  }
+  work_ready_.notify_one();
+}
+
+void ThreadPool::Wait() {
+  std::unique_lock<std::mutex> guard(lock_);
+  all_done_.wait(guard, [this] { return unfinished_ == 0; });
+}
+
+// Takes a task from the back of the worker's own deque or, failing that,
+// from the front of another one
+bool ThreadPool::Take(int self, std::function<void()>* task) {
+  int n = static_cast<int>(queues_.size());
+  for (int i = 0; i < n; i++) {
+    Queue& queue = *queues_[(self + i) % n];
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.tasks.empty()) continue;
+    if (i == 0) {
+      *task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      *task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::Work(int self) {
+  std::function<void()> task;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> guard(lock_);
+      work_ready_.wait(guard, [this] { return queued_ > 0 || stopping_; });
+      if (queued_ == 0) return;
+      queued_--;
+    }
+
+    // There are never fewer tasks in the deques than reservations, so a
+    // search that comes up empty only raced with other workers
+    while (!Take(self, &task)) std::this_thread::yield();
+    task();
+    task = nullptr;
+
+    std::lock_guard<std::mutex> guard(lock_);
+    if (--unfinished_ == 0) all_done_.notify_all();
+  }
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Work-stealing thread pool.
+ */
+#ifndef POOL_H_
+#define POOL_H_
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+// A fixed set of worker threads, each with a deque of tasks of its own.
+// Submit() deals tasks out to the deques in turn. A worker runs tasks from
+// the back of its own deque and, once that is empty, steals from the front
+// of the others, so one worker stuck on a long task does not hold up the
+// tasks that were dealt to it.
+class ThreadPool {
+ public:
+  // threads == 0 starts one worker per core
+  explicit ThreadPool(int threads);
+
+  // Runs the tasks that are still queued, then stops the workers
+  ~ThreadPool();
+
+  void Submit(std::function<void()> task);
+
+  // Returns once every task submitted so far has finished
+  void Wait();
+
+  int size() const { return static_cast<int>(workers_.size()); }
+
+ private:
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  struct Queue {
+    std::mutex lock;
+    std::deque<std::function<void()> > tasks;
+  };
+
+  bool Take(int self, std::function<void()>* task);
+  void Work(int self);
+
+  std::vector<std::unique_ptr<Queue> > queues_;
+  std::vector<std::thread> workers_;
+
+  // Guards the counters below. A worker reserves one of the queued tasks
+  // under this lock before it looks for it in the deques, so it never
+  // sleeps while a task it could run is waiting.
+  std::mutex lock_;
+  std::condition_variable work_ready_;
+  std::condition_variable all_done_;
+  int queued_;      // tasks in the deques that nobody has reserved
+  int unfinished_;  // tasks submitted and not finished yet
+  unsigned next_;   // deque that gets the next task
+  bool stopping_;
+};
+
+#endif  // POOL_H_
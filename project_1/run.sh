@@ -1,2 +1,2 @@
-g++ -std=c++11 -Werror -Wunused-value -Wall -c parser.cc lexer.cc inputbuf.cc
-g++ parser.o lexer.o inputbuf.o -o a.out
\ No newline at end of file
+g++ -std=c++11 -pthread -Werror -Wunused-value -Wall -c parser.cc lexer.cc inputbuf.cc scanner.cc batch.cc pool.cc dfa.cc tables.cc codegen.cc textstream.cc tokenfile.cc wordcache.cc
+g++ -pthread parser.o lexer.o inputbuf.o scanner.o batch.o pool.o dfa.o tables.o codegen.o textstream.o tokenfile.o wordcache.o -o a.out
\ No newline at end of file
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Table-driven scanning core shared by GetTokenMain() and SkipSpace().
+ */
+#include <cstddef>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "./scanner.h"
+
+// 1 = CC_SPACE, 2 = CC_ALPHA, 4 = CC_DIGIT, one row per 16 characters.
+// Characters 128-255 belong to no class, as with isspace() and friends in
+// the C locale.
+const unsigned char char_class[256] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 0, 0, 0, 0, 0, 0,
+  0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+  2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0,
+  0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+  2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+#if defined(__AVX2__)
+
+#define BLOCK 32
+typedef __m256i block_t;
+
+static inline block_t Load(const char* p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+static inline block_t Splat(char c) {
+  return _mm256_set1_epi8(c);
+}
+
+// Lanes whose unsigned value v - lo is at most span, i.e. lo <= v <= lo+span
+static inline block_t InRange(block_t v, char lo, char span) {
+  block_t t = _mm256_sub_epi8(v, Splat(lo));
+  return _mm256_cmpeq_epi8(_mm256_min_epu8(t, Splat(span)), t);
+}
+
+static inline block_t Equal(block_t v, char c) {
+  return _mm256_cmpeq_epi8(v, Splat(c));
+}
+
+static inline block_t Or(block_t a, block_t b) {
+  return _mm256_or_si256(a, b);
+}
+
+static inline block_t Zero() {
+  return _mm256_setzero_si256();
+}
+
+static inline unsigned Mask(block_t m) {
+  return static_cast<unsigned>(_mm256_movemask_epi8(m));
+}
+
+#elif defined(__SSE2__)
+
+#define BLOCK 16
+typedef __m128i block_t;
+
+static inline block_t Load(const char* p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+static inline block_t Splat(char c) {
+  return _mm_set1_epi8(c);
+}
+
+// Lanes whose unsigned value v - lo is at most span, i.e. lo <= v <= lo+span
+static inline block_t InRange(block_t v, char lo, char span) {
+  block_t t = _mm_sub_epi8(v, Splat(lo));
+  return _mm_cmpeq_epi8(_mm_min_epu8(t, Splat(span)), t);
+}
+
+static inline block_t Equal(block_t v, char c) {
+  return _mm_cmpeq_epi8(v, Splat(c));
+}
+
+static inline block_t Or(block_t a, block_t b) {
+  return _mm_or_si128(a, b);
+}
+
+static inline block_t Zero() {
+  return _mm_setzero_si128();
+}
+
+static inline unsigned Mask(block_t m) {
+  return static_cast<unsigned>(_mm_movemask_epi8(m));
+}
+
+#endif
+
+#ifdef BLOCK
+
+// Bit i is set when character i of the block is in one of the classes
+static inline unsigned ClassMask(block_t v, unsigned classes) {
+  block_t m = Zero();
+  if (classes & CC_SPACE)
+    m = Or(m, Or(Equal(v, ' '), InRange(v, '\t', '\r' - '\t')));
+  if (classes & CC_DIGIT)
+    m = Or(m, InRange(v, '0', 9));
+  if (classes & CC_ALPHA)
+    m = Or(m, InRange(Or(v, Splat(0x20)), 'a', 25));
+  return Mask(m);
+}
+
+#endif
+
+const char* ScanRun(const char* p, const char* end, unsigned classes,
+                    int* newlines) {
+#ifdef BLOCK
+  const unsigned all = BLOCK == 32 ? 0xFFFFFFFFu : 0xFFFFu;
+  while (end - p >= BLOCK) {
+    block_t v = Load(p);
+    unsigned in = ClassMask(v, classes);
+    unsigned length_mask = all;
+    int length = BLOCK;
+    if (in != all) {
+      length = __builtin_ctz(~in & all);
+      length_mask = (1u << length) - 1;
+    }
+    if (newlines != NULL)
+      *newlines += __builtin_popcount(Mask(Equal(v, '\n')) & length_mask);
+    p += length;
+    if (length < BLOCK)
+      return p;
+  }
+#endif
+  while (p < end && IsClass(*p, classes)) {
+    if (newlines != NULL)
+      *newlines += (*p == '\n');
+    p++;
+  }
+  return p;
+}
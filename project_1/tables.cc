@@ -0,0 +1,172 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Table files: compiled token DFAs saved to disk and mapped back in.
+ */
+#include "./tables.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+static_assert(sizeof(int) == sizeof(int32_t), "tables are stored as int32_t");
+
+#define TABLE_FILE_BYTE_ORDER 0x01020304
+
+namespace {
+
+// Size of a file with these counts, or 0 if it would not fit in a size_t
+size_t FileSize(const TableFileHeader& header, uint64_t names) {
+  uint64_t size = sizeof(TableFileHeader) + DFA_ALPHABET +
+                  sizeof(int32_t) * (2 * uint64_t(header.states) +
+                                     2 * uint64_t(header.slots)) +
+                  sizeof(uint32_t) * (uint64_t(header.tokens) + 1) + names;
+  return size == static_cast<size_t>(size) ? static_cast<size_t>(size) : 0;
+}
+
+void Append(std::string* out, const void* data, size_t size) {
+  out->append(static_cast<const char*>(data), size);
+}
+
+}  // namespace
+
+bool WriteTableFile(const std::string& path, const DfaTables& tables,
+                    const std::vector<std::string>& names,
+                    std::string* error) {
+  TableFileHeader header;
+  std::memcpy(header.magic, TABLE_FILE_MAGIC, sizeof(header.magic));
+  header.version = TABLE_FILE_VERSION;
+  header.byte_order = TABLE_FILE_BYTE_ORDER;
+  header.tokens = names.size();
+  header.states = tables.token.size();
+  header.classes = tables.classes;
+  header.slots = tables.next.size();
+
+  std::vector<uint32_t> name_offset(1, 0);
+  for (size_t i = 0; i < names.size(); i++) {
+    name_offset.push_back(name_offset.back() + names[i].size());
+  }
+
+  std::string file;
+  file.reserve(FileSize(header, name_offset.back()));
+  Append(&file, &header, sizeof(header));
+  Append(&file, tables.byte_class, sizeof(tables.byte_class));
+  Append(&file, tables.token.data(), sizeof(int32_t) * header.states);
+  Append(&file, tables.base.data(), sizeof(int32_t) * header.states);
+  Append(&file, tables.next.data(), sizeof(int32_t) * header.slots);
+  Append(&file, tables.check.data(), sizeof(int32_t) * header.slots);
+  Append(&file, name_offset.data(), sizeof(uint32_t) * name_offset.size());
+  for (size_t i = 0; i < names.size(); i++) file += names[i];
+
+  std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+  out.write(file.data(), file.size());
+  out.close();
+  if (!out) {
+    *error = path + ": " + std::strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+TableFile::TableFile()
+    : data_(NULL),
+      size_(0),
+      header_(NULL),
+      name_offset_(NULL),
+      names_(NULL) {}
+
+TableFile::~TableFile() {
+  if (data_ != NULL) munmap(data_, size_);
+}
+
+bool TableFile::Open(const std::string& path, std::string* error) {
+  int fd = open(path.c_str(), O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) < 0) {
+    *error = path + ": " + std::strerror(errno);
+    if (fd >= 0) close(fd);
+    return false;
+  }
+  if (static_cast<size_t>(st.st_size) < sizeof(TableFileHeader)) {
+    close(fd);
+    *error = path + ": not a table file";
+    return false;
+  }
+  size_ = st.st_size;
+  data_ = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data_ == MAP_FAILED) {
+    data_ = NULL;
+    *error = path + ": " + std::strerror(errno);
+    return false;
+  }
+
+  const char* p = static_cast<const char*>(data_);
+  header_ = reinterpret_cast<const TableFileHeader*>(p);
+  p += sizeof(TableFileHeader);
+  dfa_.byte_class = reinterpret_cast<const unsigned char*>(p);
+  p += DFA_ALPHABET;
+  dfa_.token = reinterpret_cast<const int*>(p);
+  dfa_.base = dfa_.token + header_->states;
+  dfa_.next = dfa_.base + header_->states;
+  dfa_.check = dfa_.next + header_->slots;
+  name_offset_ = reinterpret_cast<const uint32_t*>(dfa_.check +
+                                                   header_->slots);
+  names_ = reinterpret_cast<const char*>(name_offset_ + header_->tokens + 1);
+
+  if (!Check(error)) {
+    *error = path + ": " + *error;
+    munmap(data_, size_);
+    data_ = NULL;
+    return false;
+  }
+  return true;
+}
+
+// Checks the header and every table entry that is used as an index, so that
+// a damaged file is rejected here instead of being read out of bounds later
+bool TableFile::Check(std::string* error) const {
+  const TableFileHeader& h = *header_;
+  if (std::memcmp(h.magic, TABLE_FILE_MAGIC, sizeof(h.magic)) != 0) {
+    *error = "not a table file";
+    return false;
+  }
+  if (h.byte_order != TABLE_FILE_BYTE_ORDER) {
+    *error = "table file written with the other byte order";
+    return false;
+  }
+  if (h.version != TABLE_FILE_VERSION) {
+    *error = "table file version is not " +
+             std::to_string(TABLE_FILE_VERSION);
+    return false;
+  }
+
+  size_t fixed = FileSize(h, 0);
+  if (h.states == 0 || h.classes == 0 || h.classes > DFA_ALPHABET ||
+      fixed == 0 || fixed > size_ ||
+      size_ - fixed != name_offset_[h.tokens] || name_offset_[0] != 0) {
+    *error = "table file is damaged";
+    return false;
+  }
+  bool ok = true;
+  for (int c = 0; c < DFA_ALPHABET; c++) {
+    ok = ok && dfa_.byte_class[c] < h.classes;
+  }
+  for (uint32_t s = 0; s < h.states; s++) {
+    ok = ok && dfa_.token[s] >= -1 && dfa_.token[s] < int64_t(h.tokens) &&
+         dfa_.base[s] >= 0 && uint64_t(dfa_.base[s]) + h.classes <= h.slots;
+  }
+  for (uint32_t i = 0; i < h.slots; i++) {
+    ok = ok && dfa_.next[i] >= DFA_DEAD && dfa_.next[i] < int64_t(h.states);
+  }
+  for (uint32_t t = 0; t < h.tokens; t++) {
+    ok = ok && name_offset_[t] <= name_offset_[t + 1];
+  }
+  if (!ok) *error = "table file is damaged";
+  return ok;
+}
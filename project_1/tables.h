@@ -0,0 +1,86 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Table files: compiled token DFAs saved to disk and mapped back in.
+ */
+#ifndef TABLES_H_
+#define TABLES_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "./dfa.h"
+
+// ------- table file format -------------------
+//
+// A table file holds the comb vector tables of the DFA of a token section
+// and the names of its tokens. Tokens are numbered in the order they were
+// declared, which is also their priority: of two tokens that match the same
+// lexeme, the one with the smaller number wins, and the DFA states already
+// carry the winner. The file is laid out so that it can be used where it is
+// mapped, without parsing or copying:
+//
+//     TableFileHeader
+//     unsigned char byte_class[DFA_ALPHABET]
+//     int32_t token[states], base[states]
+//     int32_t next[slots], check[slots]
+//     uint32_t name_offset[tokens + 1]   (into the names that follow)
+//     char names[name_offset[tokens]]
+//
+// Numbers are in the byte order of the machine that wrote the file; a file
+// from a machine with the other byte order is rejected.
+
+#define TABLE_FILE_MAGIC "P1TABLES"
+#define TABLE_FILE_VERSION 1
+
+struct TableFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;  // 0x01020304 as written
+  uint32_t tokens;
+  uint32_t states;
+  uint32_t classes;
+  uint32_t slots;
+};
+
+// Writes tables and the token names, in declaration order, to path. Returns
+// false and sets error if the file cannot be written.
+bool WriteTableFile(const std::string& path, const DfaTables& tables,
+                    const std::vector<std::string>& names,
+                    std::string* error);
+
+// A table file mapped read-only into memory. Its tables can be shared by any
+// number of threads.
+class TableFile {
+ public:
+  TableFile();
+  ~TableFile();
+
+  // Maps path and checks that it is a well formed table file of this
+  // version. Returns false and sets error if it is not.
+  bool Open(const std::string& path, std::string* error);
+
+  const DfaView& dfa() const { return dfa_; }
+  int tokens() const { return static_cast<int>(header_->tokens); }
+  std::string token_name(int token) const {
+    return std::string(names_ + name_offset_[token],
+                       name_offset_[token + 1] - name_offset_[token]);
+  }
+
+ private:
+  TableFile(const TableFile&) = delete;
+  TableFile& operator=(const TableFile&) = delete;
+
+  bool Check(std::string* error) const;
+
+  void* data_;
+  size_t size_;
+  const TableFileHeader* header_;
+  DfaView dfa_;
+  const uint32_t* name_offset_;
+  const char* names_;
+};
+
+#endif  // TABLES_H_
@@ -0,0 +1,65 @@
+#!/bin/bash
+
+# Runs the tests in generate_tests through the scanner that ./a.out
+# --generate writes for their token section, and through ./a.out itself.
+# Both must print the expected output.
+
+if [ ! -d "./generate_tests" ]; then
+    echo "Error: generate_tests directory not found!"
+    exit 1
+fi
+
+if [ ! -x "./a.out" ]; then
+    echo "Error: a.out not found or not executable!"
+    exit 1
+fi
+
+let count=0
+let all=0
+
+mkdir -p ./output
+
+for test_file in $(find ./generate_tests -type f -name "*.txt" | sort); do
+    all=$((all+1))
+    name=`basename ${test_file} .txt`
+    expected_file=${test_file}.expected
+    tokens_file=./output/${name}.tokens
+    scanner=./output/${name}_scanner
+
+    # The scanner is only written for a well formed input, so give the token
+    # section a text of its own
+    sed '/#/q' ${test_file} > ${tokens_file}
+    echo '" a "' >> ${tokens_file}
+    ./a.out --generate ${scanner}.cc < ${tokens_file} > /dev/null
+    if ! g++ -std=c++11 -o ${scanner} ${scanner}.cc; then
+        echo "${name}: generated scanner does not compile"
+        echo "========================================================"
+        continue
+    fi
+
+    awk 'text { print } /#/ { text = 1 }' ${test_file} |
+        ${scanner} > ./output/${name}.scanner
+    ./a.out < ${test_file} > ./output/${name}.output
+
+    if diff -Bw ${expected_file} ./output/${name}.scanner \
+            > ./output/${name}.diff; then
+        if diff -Bw ${expected_file} ./output/${name}.output \
+                > ./output/${name}.diff; then
+            count=$((count+1))
+            echo "${name}: OK"
+        else
+            echo "${name}: a.out output does not match expected:"
+            cat ./output/${name}.diff
+        fi
+    else
+        echo "${name}: scanner output does not match expected:"
+        cat ./output/${name}.diff
+    fi
+    echo "========================================================"
+done
+
+echo
+echo "Passed $count tests out of $all"
+echo
+
+rm -rf ./output
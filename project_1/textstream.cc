@@ -0,0 +1,132 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Streaming input text: the words of a quoted INPUT_TEXT read in chunks.
+ */
+#include "./textstream.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+#include "./scanner.h"
+
+TextStream::TextStream(int fd, const char* data, const char* end)
+    : fd_(fd),
+      buffer_(std::max<size_t>(TEXT_CHUNK_SIZE, end - data)),
+      pos_(0),
+      fill_(end - data),
+      discarded_(0),
+      text_start_(0),
+      eof_(false),
+      state_(BEFORE) {
+  std::copy(data, end, buffer_.begin());
+}
+
+// Moves [keep, fill_) to the front of the buffer and reads the next chunk
+// behind it, making room for a whole chunk if the kept characters fill most
+// of the buffer. Returns false at the end of the input.
+bool TextStream::Refill(size_t keep) {
+  if (eof_) return false;
+  std::copy(buffer_.begin() + keep, buffer_.begin() + fill_, buffer_.begin());
+  fill_ -= keep;
+  pos_ -= keep;
+  discarded_ += keep;
+  if (buffer_.size() - fill_ < TEXT_CHUNK_SIZE) {
+    buffer_.resize(fill_ + TEXT_CHUNK_SIZE);
+  }
+
+  ssize_t n;
+  do {
+    n = read(fd_, &buffer_[fill_], buffer_.size() - fill_);
+  } while (n < 0 && errno == EINTR);
+  if (n <= 0) {
+    eof_ = true;
+    return false;
+  }
+  fill_ += n;
+  return true;
+}
+
+// Skips spaces, or all white space if spaces_only is false. Returns false if
+// the input ends first.
+bool TextStream::SkipSpace(bool spaces_only) {
+  for (;;) {
+    while (pos_ < fill_ && (spaces_only ? buffer_[pos_] == ' '
+                                        : IsClass(buffer_[pos_], CC_SPACE))) {
+      pos_++;
+    }
+    if (pos_ < fill_) return true;
+    if (!Refill(pos_)) return false;
+  }
+}
+
+bool TextStream::NextWord(const char** word, const char** word_end) {
+  for (;;) {
+    switch (state_) {
+      case BEFORE:
+        if (!SkipSpace(false) || buffer_[pos_] != '"') {
+          state_ = BAD;
+          return false;
+        }
+        pos_++;
+        text_start_ = discarded_ + pos_;
+        state_ = INSIDE;
+        break;
+
+      case INSIDE: {
+        if (!SkipSpace(true)) {
+          state_ = BAD;
+          return false;
+        }
+        if (buffer_[pos_] == '"') {
+          pos_++;
+          state_ = AFTER;
+          break;
+        }
+
+        // A word is letters, digits and white space other than ' '
+        size_t start = pos_;
+        for (;;) {
+          const char* base = buffer_.data();
+          pos_ = ScanRun(base + pos_, base + fill_, CC_ALNUM, NULL) - base;
+          if (pos_ < fill_ && buffer_[pos_] != ' ' &&
+              IsClass(buffer_[pos_], CC_SPACE)) {
+            pos_++;
+            continue;
+          }
+          if (pos_ < fill_) break;
+          if (!Refill(start)) {
+            state_ = BAD;
+            return false;
+          }
+          start = 0;
+        }
+        if (buffer_[pos_] != ' ' && buffer_[pos_] != '"') {
+          state_ = BAD;
+          return false;
+        }
+        *word = buffer_.data() + start;
+        *word_end = buffer_.data() + pos_;
+        return true;
+      }
+
+      case AFTER:
+        state_ = SkipSpace(false) ? BAD : DONE;
+        return false;
+
+      case DONE:
+      case BAD:
+        return false;
+    }
+  }
+}
+
+bool TextStream::Validate() {
+  const char* word;
+  const char* word_end;
+  while (NextWord(&word, &word_end)) {
+  }
+  return !error();
+}
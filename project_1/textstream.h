@@ -0,0 +1,65 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Streaming input text: the words of a quoted INPUT_TEXT read in chunks.
+ */
+#ifndef TEXTSTREAM_H_
+#define TEXTSTREAM_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <vector>
+
+#define TEXT_CHUNK_SIZE (1 << 16)
+
+// Reads a quoted input text from a file descriptor TEXT_CHUNK_SIZE bytes at a
+// time and hands out its words, the runs of characters between spaces that
+// split() would return. Only the current word and the chunk it ends in are
+// kept, so memory stays bounded by the chunk size and the longest word
+// however long the text is. A word that runs across the end of a chunk is
+// moved to the front of the buffer before the next chunk is read behind it.
+class TextStream {
+ public:
+  // Reads fd after the bytes [data, end), which were read from it already
+  TextStream(int fd, const char* data, const char* end);
+
+  // Sets [*word, *word_end) to the next word, valid until the next call.
+  // Returns false at the end of the text or at the first character that
+  // does not belong in it; error() tells the two apart.
+  bool NextWord(const char** word, const char** word_end);
+
+  // Reads the rest of the input and returns false if it is not a well formed
+  // text, without handing out the words
+  bool Validate();
+
+  // Where p, in the word NextWord() handed out last, is in the text, counted
+  // from the character after the opening quote
+  uint64_t Offset(const char* p) const {
+    return discarded_ + (p - buffer_.data()) - text_start_;
+  }
+
+  // The input is not one INPUT_TEXT (letters, digits and white space in
+  // double quotes) followed by white space only
+  bool error() const { return state_ == BAD; }
+
+ private:
+  TextStream(const TextStream&) = delete;
+  TextStream& operator=(const TextStream&) = delete;
+
+  enum State { BEFORE, INSIDE, AFTER, DONE, BAD };
+
+  bool Refill(size_t keep);
+  bool SkipSpace(bool spaces_only);
+
+  int fd_;
+  std::vector<char> buffer_;
+  size_t pos_;   // next character to look at
+  size_t fill_;  // end of the characters read
+  uint64_t discarded_;   // characters read before the start of the buffer
+  uint64_t text_start_;  // after the opening quote, counted like discarded_
+  bool eof_;
+  State state_;
+};
+
+#endif  // TEXTSTREAM_H_
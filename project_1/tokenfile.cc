@@ -0,0 +1,128 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Token files: the tokens of an input text as binary columns.
+ */
+#include "./tokenfile.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#define TOKEN_FILE_BYTE_ORDER 0x01020304
+
+void TokenRecords::Add(int token, uint64_t offset, uint32_t length) {
+  this->offset.push_back(offset);
+  this->length.push_back(length);
+  this->token.push_back(token);
+}
+
+void TokenRecords::clear() {
+  offset.clear();
+  length.clear();
+  token.clear();
+}
+
+TokenWriter::TokenWriter() : fd_(-1), errno_(0) {}
+
+TokenWriter::~TokenWriter() {
+  if (fd_ >= 0) close(fd_);
+}
+
+bool TokenWriter::Open(const std::string& path, std::string* error) {
+  fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd_ < 0) {
+    *error = path + ": " + std::strerror(errno);
+    return false;
+  }
+  path_ = path;
+  block_.offset.reserve(TOKEN_BLOCK_RECORDS);
+  block_.length.reserve(TOKEN_BLOCK_RECORDS);
+  block_.token.reserve(TOKEN_BLOCK_RECORDS);
+  return true;
+}
+
+void TokenWriter::Start(const std::vector<std::string>& names) {
+  TokenFileHeader header;
+  std::memcpy(header.magic, TOKEN_FILE_MAGIC, sizeof(header.magic));
+  header.version = TOKEN_FILE_VERSION;
+  header.byte_order = TOKEN_FILE_BYTE_ORDER;
+  header.tokens = names.size();
+  header.reserved = 0;
+
+  std::vector<uint32_t> name_offset(1, 0);
+  std::string all_names;
+  for (size_t i = 0; i < names.size(); i++) {
+    all_names += names[i];
+    name_offset.push_back(all_names.size());
+  }
+  size_t size = sizeof(header) + sizeof(uint32_t) * name_offset.size() +
+                all_names.size();
+  all_names.append((8 - size % 8) % 8, '\0');
+
+  struct iovec parts[3] = {
+      {&header, sizeof(header)},
+      {name_offset.data(), sizeof(uint32_t) * name_offset.size()},
+      {&all_names[0], all_names.size()}};
+  Write(parts, 3);
+}
+
+void TokenWriter::Add(int token, uint64_t offset, uint32_t length) {
+  block_.Add(token, offset, length);
+  if (block_.size() == TOKEN_BLOCK_RECORDS) Flush();
+}
+
+void TokenWriter::Append(const TokenRecords& records) {
+  for (size_t i = 0; i < records.size(); i++) {
+    Add(records.token[i], records.offset[i], records.length[i]);
+  }
+}
+
+bool TokenWriter::Finish(std::string* error) {
+  if (block_.size() > 0) Flush();
+  Flush();  // the end block
+  if (close(fd_) < 0 && errno_ == 0) errno_ = errno;
+  fd_ = -1;
+  if (errno_ != 0) {
+    *error = path_ + ": " + std::strerror(errno_);
+    return false;
+  }
+  return true;
+}
+
+// Writes the records collected so far as one block
+void TokenWriter::Flush() {
+  TokenBlockHeader header;
+  header.records = block_.size();
+  header.reserved = 0;
+  struct iovec parts[4] = {
+      {&header, sizeof(header)},
+      {block_.offset.data(), sizeof(uint64_t) * block_.size()},
+      {block_.length.data(), sizeof(uint32_t) * block_.size()},
+      {block_.token.data(), sizeof(int32_t) * block_.size()}};
+  Write(parts, 4);
+  block_.clear();
+}
+
+// Writes all of parts, which it changes, going on after short writes. After
+// a failed write nothing more is written.
+void TokenWriter::Write(struct iovec* parts, int count) {
+  while (count > 0 && errno_ == 0) {
+    ssize_t n = writev(fd_, parts, count);
+    if (n < 0) {
+      if (errno != EINTR) errno_ = errno;
+      continue;
+    }
+    while (count > 0 && static_cast<size_t>(n) >= parts->iov_len) {
+      n -= parts->iov_len;
+      parts++;
+      count--;
+    }
+    if (count > 0) {
+      parts->iov_base = static_cast<char*>(parts->iov_base) + n;
+      parts->iov_len -= n;
+    }
+  }
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Token files: the tokens of an input text as binary columns.
+ */
+#ifndef TOKENFILE_H_
+#define TOKENFILE_H_
+
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include <string>
+#include <vector>
+
+// ------- token file format -------------------
+//
+// A token file holds the tokens my_get_token() would print, without their
+// lexemes: for every token its number, and where its lexeme starts in the
+// input text and how long it is. The lexemes can be read from the input
+// text, and the numbers looked up in the token names at the start:
+//
+//     TokenFileHeader
+//     uint32_t name_offset[tokens + 1]   (into the names that follow)
+//     char names[name_offset[tokens]]
+//     '\0' padding up to the next multiple of 8 bytes from the start
+//     blocks
+//
+// The records come in blocks of up to TOKEN_BLOCK_RECORDS records, each a
+// column per field:
+//
+//     TokenBlockHeader
+//     uint64_t offset[records]  (from the character after the opening quote)
+//     uint32_t length[records]
+//     int32_t token[records]
+//
+// A record with token -1 and length 0 takes the place of ERROR: no token
+// matches at its offset, and no records follow it. The last block has no
+// records; a file that does not end with it was cut short by a syntax error
+// found in the input text after its first tokens had been written.
+//
+// Numbers are in the byte order of the machine that wrote the file, and
+// byte_order tells which it is.
+
+#define TOKEN_FILE_MAGIC "P1TOKENS"
+#define TOKEN_FILE_VERSION 1
+#define TOKEN_BLOCK_RECORDS (1 << 16)
+
+struct TokenFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;  // 0x01020304 as written
+  uint32_t tokens;
+  uint32_t reserved;    // 0
+};
+
+struct TokenBlockHeader {
+  uint32_t records;
+  uint32_t reserved;  // 0
+};
+
+// Token records in columns, as they are laid out in a block
+struct TokenRecords {
+  std::vector<uint64_t> offset;
+  std::vector<uint32_t> length;
+  std::vector<int32_t> token;
+
+  void Add(int token, uint64_t offset, uint32_t length);
+  size_t size() const { return token.size(); }
+  void clear();
+};
+
+// Writes a token file. Records are collected into blocks of
+// TOKEN_BLOCK_RECORDS, and every block goes out in a single writev() of its
+// columns, so the output costs a system call per block rather than a
+// formatted line and a flush per token.
+class TokenWriter {
+ public:
+  TokenWriter();
+  ~TokenWriter();
+
+  // Creates or truncates path. Returns false and sets error if it cannot.
+  bool Open(const std::string& path, std::string* error);
+
+  // Writes the header with the token names in declaration order. Must be
+  // called once, before the records.
+  void Start(const std::vector<std::string>& names);
+
+  void Add(int token, uint64_t offset, uint32_t length);
+  void Append(const TokenRecords& records);
+
+  // Writes the last records and the end block and closes the file. Returns
+  // false and sets error if some write failed.
+  bool Finish(std::string* error);
+
+ private:
+  TokenWriter(const TokenWriter&) = delete;
+  TokenWriter& operator=(const TokenWriter&) = delete;
+
+  void Flush();
+  void Write(struct iovec* parts, int count);
+
+  std::string path_;
+  int fd_;
+  int errno_;  // of the first write that failed, or 0
+  TokenRecords block_;
+};
+
+#endif  // TOKENFILE_H_
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Word cache: the tokens of recently scanned words, by their bytes.
+ */
+#include "./wordcache.h"
+
+#include <cstring>
+
+void WordTokens::Add(int token, int length) {
+  this->token.push_back(token);
+  this->length.push_back(length);
+}
+
+void WordTokens::clear() {
+  token.clear();
+  length.clear();
+  error = false;
+}
+
+WordCache::WordCache(int slots) : size_(0), mask_(0), hits_(0), misses_(0) {
+  if (slots <= 0) return;
+  size_ = 1;
+  while (size_ < static_cast<size_t>(slots)) size_ *= 2;
+  mask_ = size_ - 1;
+}
+
+WordTokens* WordCache::Lookup(const char* word, size_t size, bool* hit) {
+  *hit = false;
+  if (size_ == 0 || size > WORD_CACHE_MAX_LENGTH) {
+    misses_++;
+    return NULL;
+  }
+  if (slots_.empty()) {
+    slots_.resize(size_);
+    for (size_t i = 0; i < size_; i++) slots_[i].used = false;
+  }
+
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ static_cast<unsigned char>(word[i])) * 16777619u;
+  }
+  Slot& slot = slots_[hash & mask_];
+  if (slot.used && slot.word.size() == size &&
+      std::memcmp(slot.word.data(), word, size) == 0) {
+    hits_++;
+    *hit = true;
+    return &slot.tokens;
+  }
+  misses_++;
+  slot.used = true;
+  slot.word.assign(word, size);
+  slot.tokens.clear();
+  return &slot.tokens;
+}
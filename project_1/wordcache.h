@@ -0,0 +1,67 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Word cache: the tokens of recently scanned words, by their bytes.
+ */
+#ifndef WORDCACHE_H_
+#define WORDCACHE_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#define WORD_CACHE_SLOTS 4096
+#define WORD_CACHE_MAX_LENGTH 64  // longer words are never cached
+
+// The tokens a word splits into, as my_get_token() finds them. If error is
+// set, no token matches at the end of the tokens there are.
+struct WordTokens {
+  std::vector<int> token;
+  std::vector<int> length;
+  bool error;
+
+  void Add(int token, int length);
+  void clear();
+};
+
+// A bounded hash table from the bytes of a word to its tokens. Each word has
+// one slot, picked by its hash, and a word that maps to a taken slot evicts
+// the word in it, so the cache never holds more than its number of slots and
+// a lookup costs one hash and one compare. Slots are allocated on first use
+// and their vectors are reused, so a warm cache does not allocate.
+//
+// Not thread safe; every thread needs a cache of its own.
+class WordCache {
+ public:
+  // slots is rounded up to a power of two; with 0 nothing is ever cached
+  explicit WordCache(int slots);
+
+  // Returns the tokens cached for [word, word + size) and sets hit, or, on a
+  // miss, clears hit and returns the slot for the word, which the caller
+  // must fill. Returns NULL for words that are not cached at all.
+  WordTokens* Lookup(const char* word, size_t size, bool* hit);
+
+  uint64_t hits() const { return hits_; }
+  uint64_t misses() const { return misses_; }
+  size_t slots() const { return size_; }
+
+ private:
+  WordCache(const WordCache&) = delete;
+  WordCache& operator=(const WordCache&) = delete;
+
+  struct Slot {
+    std::string word;
+    bool used;
+    WordTokens tokens;
+  };
+
+  size_t size_;  // slots to allocate
+  size_t mask_;
+  std::vector<Slot> slots_;
+  uint64_t hits_;
+  uint64_t misses_;
+};
+
+#endif  // WORDCACHE_H_
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Lexer throughput benchmark. For every size given on the command line (in
+ * MB, 1 to 1024) a SCALAR/ARRAY program of that size is generated
+ * into a temporary file, standard input is pointed at it and the
+ * LexicalAnalyzer constructor and the GetToken() loop are timed on their
+ * own. Nothing is parsed or executed.
+ *
+ * Build and run from project_2 with
+ *
+ *     sh bench/run.sh [--pretokenize | --stream] [MB ...]
+ *
+ * Without a mode both modes are measured. PRETOKENIZE keeps every token in
+ * memory (sizeof(Token) per token), so use --stream for the largest sizes.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../lexer.h"
+
+using namespace std;
+
+#define MB (1024L * 1024L)
+
+// ------- input generator -------------------
+
+static unsigned long seed = 340;
+
+static int Random(int n)
+{
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    return (int) ((seed >> 33) % n);
+}
+
+static string Scalar()
+{
+    static const char* names[] = { "x", "y", "z", "sum", "count", "i1" };
+    return names[Random(6)];
+}
+
+static string Array()
+{
+    static const char* names[] = { "a", "b", "c", "table", "row", "v2" };
+    return names[Random(6)];
+}
+
+static string Expr(int depth)
+{
+    static const char* ops[] = { "+", "-", "*", "/" };
+    int value = Random(4) == 0 ? Random(100000) : Random(10);
+    switch (depth > 2 ? Random(3) : Random(6)) {
+        case 0:  return to_string(value);
+        case 1:  return Scalar();
+        case 2:  return Array() + "[.]";
+        case 3:  return Array() + "[" + Expr(depth + 1) + "]";
+        case 4:  return "(" + Expr(depth + 1) + ")";
+        default: return Expr(depth + 1) + ops[Random(4)] + Expr(depth + 1);
+    }
+}
+
+// Appends one statement, roughly 20 bytes of source
+static void Statement(string& out)
+{
+    switch (Random(6)) {
+        case 0:
+            out += "OUTPUT " + Scalar() + ";\n";
+            break;
+        case 1:
+            out += "OUTPUT " + Array() + "[" + Expr(1) + "];\n";
+            break;
+        case 2:
+            out += Array() + "[.] = " + Expr(0) + ";\n";
+            break;
+        case 3:
+            out += Array() + "[" + Expr(2) + "] = " + Expr(0) + ";\n";
+            break;
+        default:
+            out += Scalar() + " = " + Expr(0) + ";\n";
+            break;
+    }
+}
+
+// Writes a program of about "size" bytes to fd
+static void Generate(int fd, long size)
+{
+    string out = "SCALAR x y z sum count i1\nARRAY a b c table row v2\n{\n";
+    long written = 0;
+    while (written + (long) out.size() < size - 2) {
+        Statement(out);
+        if (out.size() >= 1 << 20) {
+            written += write(fd, out.data(), out.size());
+            out.clear();
+        }
+    }
+    out += "}\n";
+    written += write(fd, out.data(), out.size());
+}
+
+// ------- timing -------------------
+
+static double Seconds(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start)
+        .count();
+}
+
+static void Report(const char* what, long bytes, long tokens, double seconds)
+{
+    printf("  %-24s %9.3f s %10.1f MB/s %12.0f tokens/s\n", what, seconds,
+           bytes / seconds / MB, tokens / seconds);
+}
+
+// Lexes the file open on fd with a fresh lexer in the given mode
+static void Measure(int fd, long bytes, LexerMode mode)
+{
+    lseek(fd, 0, SEEK_SET);
+    dup2(fd, STDIN_FILENO);
+    LexicalAnalyzer::SetMode(mode);
+
+    auto start = chrono::steady_clock::now();
+    LexicalAnalyzer lexer;
+    double construct = Seconds(start);
+
+    long tokens = 0;
+    start = chrono::steady_clock::now();
+    while (lexer.GetToken().token_type != END_OF_FILE)
+        tokens++;
+    double loop = Seconds(start);
+
+    if (mode == PRETOKENIZE) {
+        Report("constructor", bytes, tokens, construct);
+        Report("GetToken loop", bytes, tokens, loop);
+    } else {
+        Report("streaming GetToken loop", bytes, tokens, construct + loop);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bool pretokenize = true;
+    bool streaming = true;
+    vector<long> sizes;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--pretokenize") == 0) {
+            streaming = false;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            pretokenize = false;
+        } else if (atol(argv[i]) >= 1 && atol(argv[i]) <= 1024) {
+            sizes.push_back(atol(argv[i]));
+        } else {
+            printf("usage: %s [--pretokenize | --stream] [MB ...]\n",
+                   argv[0]);
+            return 1;
+        }
+    }
+    if (sizes.empty()) {
+        sizes.push_back(1);
+        sizes.push_back(16);
+        sizes.push_back(128);
+    }
+
+    for (size_t i = 0; i < sizes.size(); i++) {
+        char path[] = "/tmp/lexer_benchXXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0) {
+            perror("mkstemp");
+            return 1;
+        }
+        unlink(path);
+        Generate(fd, sizes[i] * MB);
+        long bytes = lseek(fd, 0, SEEK_END);
+
+        printf("%ld MB program (%ld bytes)\n", sizes[i], bytes);
+        if (pretokenize)
+            Measure(fd, bytes, PRETOKENIZE);
+        if (streaming)
+            Measure(fd, bytes, STREAMING);
+        close(fd);
+    }
+    return 0;
+}
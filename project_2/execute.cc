@@ -3,6 +3,7 @@
 #include <cstdlib>
 #include <vector>
 #include <string>
+#include "batch.h"
 #include "execute.h"
 
 // addrType specifies how the value of the argument is obtained.
@@ -82,21 +83,20 @@ void print_instNode(struct instNode *il)
 	cout << "Next : " << il->next << endl;
 }
 
-long mem[MEMSIZE];
-
-
-void execute_inst_list(struct instNode * il)
+void execute_inst_list(struct instNode * il, Context& context)
 {
 	struct instNode * pc = il;
+	long * mem = context.mem;
+	ostream& out = context.out;
 
 	while (pc != nullptr) {
 		long lhsadr, op1, op2;
 		lhsadr = op1 = op2 = 0;
 		lhsadr = pc->lhs;
 		if ((outofbound(pc->lhs))&(pc->iType == ASSIGN_INST)) {
-			cout << "out of bound memory access" << 
+			out << "out of bound memory access" << 
 				" pc->lhs " << pc->lhs << endl;
-			exit(-1);
+			Exit(-1);
 		}
 		if (pc->iType == ASSIGN_INST) {
 			switch (pc->lhsat) {
@@ -104,21 +104,21 @@ void execute_inst_list(struct instNode * il)
 					break;
 				case INDIRECT: lhsadr = mem[pc->lhs];
 				  	break;
-				case NOAT: cout << "lhs address type not initialized" 
+				case NOAT: out << "lhs address type not initialized" 
 				   		<< endl;
 				  	break;
-				default: cout << "invalid addressing mode lhs" << endl;
+				default: out << "invalid addressing mode lhs" << endl;
 			}
 			if (outofbound(lhsadr) ) {
-				cout << "out of bound memory access" << 
+				out << "out of bound memory access" << 
 					" lhsadr " << lhsadr << endl;
-				exit(-1);
+				Exit(-1);
 			}
 		}
 		if (outofbound(pc->op1)&(pc->op1at != IMMEDIATE)) {
-			cout << "out of bound memory access" << 
+			out << "out of bound memory access" << 
 				" pc->op1 " << pc->op1 << endl;
-			exit(-1);
+			Exit(-1);
 		}
 		switch (pc->op1at) {
 			case IMMEDIATE: op1 = pc->op1;
@@ -126,23 +126,23 @@ void execute_inst_list(struct instNode * il)
 			case DIRECT: op1 = mem[pc->op1];
 				break;
 			case INDIRECT: if (outofbound(mem[pc->op1])) {
-						cout << "out of bound memory access" << 
+						out << "out of bound memory access" << 
 							" mem[pc->op1] " << mem[pc->op1] << endl;
-						exit(-1);
+						Exit(-1);
 					}
 				        op1 = mem[mem[pc->op1]];
 				  break;
-			case NOAT: cout << "op1 address type not initialized" 
+			case NOAT: out << "op1 address type not initialized" 
 				   	<< endl;
-			default: cout << "invalid addressing mode lhs" << endl;
+			default: out << "invalid addressing mode lhs" << endl;
 		}
 
 		if ((pc->oper == OP_PLUS)|(pc->oper == OP_MINUS)|
 		    (pc->oper == OP_MULT)|(pc->oper == OP_DIV)) {
 			if (outofbound(pc->op2)&(pc->op2at != IMMEDIATE)) {
-				cout << "out of bound memory access" << 
+				out << "out of bound memory access" << 
 					" pc->op2 " << pc->op2 << endl;
-				exit(-1);
+				Exit(-1);
 			}
 			switch (pc->op2at) {
 				case IMMEDIATE: op2 = pc->op2;
@@ -150,26 +150,26 @@ void execute_inst_list(struct instNode * il)
 				case DIRECT: op2 = mem[pc->op2];
 					break;
 				case INDIRECT: if (outofbound(mem[pc->op2])) {
-							cout << "out of bound memory access" << 
+							out << "out of bound memory access" << 
 								" mem[pc->op2] " << mem[pc->op2] << endl;
-							exit(-1);
+							Exit(-1);
 						}
 					        op2 = mem[mem[pc->op2]];
 				  	break;
 				case NA: break;
-				case NOAT: cout << "op2 address type not initialized" 
+				case NOAT: out << "op2 address type not initialized" 
 				   		<< endl;
-				default: cout << "invalid addressing mode lhs" << endl;
+				default: out << "invalid addressing mode lhs" << endl;
 			}
 		}
 
 		if ((pc->iType == CJMP_INST)& outofbound(pc->cjmpVar))  {
-			cout << "out of bound memory access" << "cjmpVar" << pc->cjmpVar << endl;
-			exit(-1);
+			out << "out of bound memory access" << "cjmpVar" << pc->cjmpVar << endl;
+			Exit(-1);
 		}
 
 		switch (pc->iType) {
-			case OUTPUT_INST: cout << op1 << endl;
+			case OUTPUT_INST: out << op1 << endl;
 					  pc = pc->next;
 					  break;
 			case ASSIGN_INST: switch (pc->oper) {
@@ -183,7 +183,7 @@ void execute_inst_list(struct instNode * il)
 						   	break;
 						case OP_DIV:  mem[lhsadr] = op1/op2;
 						   	break;
-						case OP_NOOPT: cout << "Operator Not Initialized" 
+						case OP_NOOPT: out << "Operator Not Initialized" 
 						    		<< endl;
 						   	break;
 						}
@@ -194,10 +194,10 @@ void execute_inst_list(struct instNode * il)
 					else
 						pc = pc->next;
 					break;
-			case NOIT:	cout << "Instruction Type Note Initialized" << endl;;
+			case NOIT:	out << "Instruction Type Note Initialized" << endl;;
 					pc = nullptr;
 					break;
-			default:	cout << "Invalid Instruction Type" << endl;;
+			default:	out << "Invalid Instruction Type" << endl;;
 					pc = nullptr;
 		}
 	}
@@ -1,5 +1,9 @@
 #ifndef _EXECUTE
 #define _EXECUTE
+#include <memory>
+#include <ostream>
+#include <vector>
+
 const int MEMSIZE = 10000;
 
 #define outofbound(index)  ((index < 0) | (index >= MEMSIZE))
@@ -38,9 +42,27 @@ struct instNode {
 	}
 };
 
+// The memory and output of one program. Every compilation has a context of
+// its own, so several programs can be compiled and run on different
+// threads at the same time.
+struct Context {
+	long mem[MEMSIZE];
+	ostream& out;
+
+	// The instructions of the program, freed with the context
+	vector<unique_ptr<instNode> > instructions;
+
+	explicit Context(ostream& out) : mem(), out(out) {}
+
+	instNode * new_instruction() {
+		instructions.emplace_back(new instNode());
+		return instructions.back().get();
+	}
+};
+
 bool valid_instType(InstType);
 bool valid_addrType(AddrType);
 void print_instNode(struct instNode *);
-void execute_inst_list(struct instNode *);
+void execute_inst_list(struct instNode *, Context&);
 
 #endif
@@ -6,18 +6,55 @@
 #ifndef __INPUT_BUFFER__H__
 #define __INPUT_BUFFER__H__
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
+// The whole input is made available as one contiguous block: standard input
+// is memory mapped when it is redirected from a regular file and read into a
+// single buffer otherwise. GetChar() moves a cursor over the block and
+// UngetChar() of the character just read moves it back; anything else that
+// is pushed back goes to input_buffer as before.
 class InputBuffer {
   public:
+    InputBuffer();
+    ~InputBuffer();
+
     void GetChar(char&);
     char UngetChar(char);
     std::string UngetString(std::string);
     bool EndOfInput();
 
+    // Direct access for the scanners: [Position(), End()) is the rest of the
+    // block and Seek() moves the cursor to a position inside it. Only
+    // meaningful while nothing foreign has been pushed back.
+    const char* Position();
+    const char* End();
+    void Seek(const char*);
+
+    // Makes buffers that are created afterwards on the calling thread read
+    // [data, data + size) instead of standard input, for batch mode.
+    // SetSource(NULL, 0) goes back to standard input.
+    static void SetSource(const char* data, size_t size);
+
   private:
+    InputBuffer(const InputBuffer&) = delete;
+    InputBuffer& operator=(const InputBuffer&) = delete;
+
+    void Load();
+
+    static thread_local const char* source;
+    static thread_local size_t source_size;
+
     std::vector<char> input_buffer;
+    std::vector<char> block;
+    const char* data;
+    size_t size;
+    size_t pos;
+    void* mapping;
+    size_t mapping_size;
+    bool loaded;
+    bool eof;
 };
 
 #endif  //__INPUT_BUFFER__H__
@@ -8,9 +8,13 @@
 #include <vector>
 #include <string>
 #include <cctype>
+#include <cstring>
 
 #include "lexer.h"
+#include "batch.h"
 #include "inputbuf.h"
+#include "scanner.h"
+#include "keyword.h"
 
 using namespace std;
 
@@ -21,24 +25,49 @@ string reserved[] = { "END_OF_FILE",
     "DOT", "NUM", "ID", "ERROR"
 };
 
-#define KEYWORDS_COUNT 3
-
 void Token::Print()
 {
-    cout << "{" << this->lexeme << " , "
-         << reserved[(int) this->token_type] << " , "
+    cout << "{";
+    cout.write(this->text, this->length);
+    cout << " , " << reserved[(int) this->token_type] << " , "
          << this->line_no << "}\n";
 }
 
+bool Token::SameLexeme(const Token& other) const
+{
+    return length == other.length && memcmp(text, other.text, length) == 0;
+}
+
+LexerMode LexicalAnalyzer::default_mode = PRETOKENIZE;
+
+// Selects the mode of the lexers constructed afterwards
+void LexicalAnalyzer::SetMode(LexerMode mode)
+{
+    default_mode = mode;
+}
+
+// In STREAMING mode nothing is read until the first GetToken() or peek()
 LexicalAnalyzer::LexicalAnalyzer()
 {
     this->line_no = 1;
-    tmp.lexeme = "";
     tmp.line_no = 1;
     tmp.token_type = ERROR;
+    error_out = &cout;
+    mode = default_mode;
+    intern = true;
+    index = 0;
+    scanned = 0;
+    scanned_all = false;
+
+    if (mode == STREAMING)
+        return;
+    if (mode == PIPELINED) {
+        pipe.resize(PIPE_SIZE);
+        producer = thread(&LexicalAnalyzer::Produce, this);
+        return;
+    }
 
     Token token = GetTokenMain();
-    index = 0;
 
     while (token.token_type != END_OF_FILE)
     {
@@ -48,108 +77,156 @@ LexicalAnalyzer::LexicalAnalyzer()
     // pushes END_OF_FILE is not pushed on the token list
 }
 
-bool LexicalAnalyzer::SkipSpace()
+LexicalAnalyzer::~LexicalAnalyzer()
 {
-    char c;
-    bool space_encountered = false;
-
-    input.GetChar(c);
-    line_no += (c == '\n');
-
-    while (!input.EndOfInput() && isspace(c)) {
-        space_encountered = true;
-        input.GetChar(c);
-        line_no += (c == '\n');
+    if (producer.joinable()) {
+        stopping = true;
+        producer.join();
     }
+}
 
-    if (!input.EndOfInput()) {
-        input.UngetChar(c);
+// Runs on the producer thread in PIPELINED mode. The producer is the only
+// writer of "produced" and the consumer the only writer of "released". A
+// slot is only overwritten after the consumer has released it, and a new
+// token becomes visible to the consumer with the store to "produced".
+void LexicalAnalyzer::Produce()
+{
+    int n = 0;
+    while (!stopping.load(memory_order_relaxed)) {
+        Token token = GetTokenMain();
+        if (token.token_type == END_OF_FILE)
+            break;
+        while (n - released.load(memory_order_acquire) >= PIPE_SIZE) {
+            if (stopping.load(memory_order_relaxed))
+                return;
+            this_thread::yield();
+        }
+        pipe[n % PIPE_SIZE] = token;
+        produced.store(++n, memory_order_release);
     }
-    return space_encountered;
+    produced_all.store(true, memory_order_release);
 }
 
-int LexicalAnalyzer::FindKeywordIndex(string s)
+// Waits until the token howFar positions ahead of index is in the pipe or
+// the producer has reached the end of the input, and returns the number of
+// tokens produced so far. Once produced_all is set, line_no is final.
+int LexicalAnalyzer::Wait(int howFar)
 {
-    string keyword[] = {"SCALAR", "ARRAY", "OUTPUT"};
-    for (int i = 0; i < KEYWORDS_COUNT; i++) {
-        if (s == keyword[i]) {
-            return i + 1;
-        }
+    int n = produced.load(memory_order_acquire);
+    while (n < index + howFar) {
+        if (produced_all.load(memory_order_acquire))
+            return produced.load(memory_order_acquire);
+        this_thread::yield();
+        n = produced.load(memory_order_acquire);
     }
-    return -1;
+    return n;
+}
+
+bool LexicalAnalyzer::SkipSpace()
+{
+    const char* p = input.Position();
+    const char* q = ScanRun(p, input.End(), CC_SPACE, &line_no);
+
+    input.Seek(q);
+    return q != p;
+}
+
+int LexicalAnalyzer::FindKeywordIndex(const char* s, int length)
+{
+    int i = KeywordLookup(s, length);
+    return i == -1 ? -1 : i + 1;
 }
 
+// ScanNumber() is called with the cursor on a digit. As before, a leading 0
+// is a number by itself.
 Token LexicalAnalyzer::ScanNumber()
 {
-    char c;
+    const char* p = input.Position();
+    const char* q = p + 1;
 
-    input.GetChar(c);
-    if (isdigit(c)) {
-        if (c == '0') {
-            tmp.lexeme = "0";
-        } else {
-            tmp.lexeme = "";
-            while (!input.EndOfInput() && isdigit(c)) {
-                tmp.lexeme += c;
-                input.GetChar(c);
-            }
-            if (!input.EndOfInput()) {
-                input.UngetChar(c);
-            }
-        }
-        tmp.token_type = NUM;
-        tmp.line_no = line_no;
-        return tmp;
-    } else {
-        if (!input.EndOfInput()) {
-            input.UngetChar(c);
-        }
-        tmp.lexeme = "";
-        tmp.token_type = ERROR;
-        tmp.line_no = line_no;
-        return tmp;
-    }
+    if (*p != '0')
+        q = ScanRun(q, input.End(), CC_DIGIT, NULL);
+
+    unsigned value = 0;
+    for (const char* d = p; d < q; d++)
+        value = value * 10 + (*d - '0');
+
+    input.Seek(q);
+    tmp.text = p;
+    tmp.length = q - p;
+    tmp.value = (int) value;
+    tmp.token_type = NUM;
+    tmp.line_no = line_no;
+    return tmp;
 }
 
+// ScanIdOrKeyword() is called with the cursor on a letter
 Token LexicalAnalyzer::ScanIdOrKeyword()
 {
-    char c;
-    input.GetChar(c);
+    const char* p = input.Position();
+    const char* q = ScanRun(p + 1, input.End(), CC_ALNUM, NULL);
 
-    if (isalpha(c)) {
-        tmp.lexeme = "";
-        while (!input.EndOfInput() && isalnum(c)) {
-            tmp.lexeme += c;
-            input.GetChar(c);
-        }
-        if (!input.EndOfInput()) {
-            input.UngetChar(c);
-        }
-        tmp.line_no = line_no;
-        int keywordIndex = FindKeywordIndex(tmp.lexeme);
-        if (keywordIndex != -1)
-            tmp.token_type = (TokenType) keywordIndex;
-        else
-            tmp.token_type = ID;
+    input.Seek(q);
+    tmp.text = p;
+    tmp.length = q - p;
+    tmp.line_no = line_no;
+    int keywordIndex = FindKeywordIndex(tmp.text, tmp.length);
+    if (keywordIndex != -1) {
+        tmp.token_type = (TokenType) keywordIndex;
     } else {
-        if (!input.EndOfInput()) {
-            input.UngetChar(c);
-        }
-        tmp.lexeme = "";
-        tmp.token_type = ERROR;
+        tmp.token_type = ID;
+        if (intern)
+            tmp.symbol = symbols.Intern(tmp.text, tmp.length);
     }
     return tmp;
 }
 
+// Fill() scans tokens into the ring until the token "howFar" positions
+// ahead of index is available or the input is exhausted
+void LexicalAnalyzer::Fill(int howFar)
+{
+    while (!scanned_all && scanned < index + howFar) {
+        Token token = GetTokenMain();
+        if (token.token_type == END_OF_FILE) {
+            scanned_all = true;
+        } else {
+            ring[scanned % RING_SIZE] = token;
+            scanned++;
+        }
+    }
+}
+
+const Token& LexicalAnalyzer::EndOfFileToken()
+{
+    end_of_file.length = 0;
+    end_of_file.line_no = line_no;
+    end_of_file.token_type = END_OF_FILE;
+    return end_of_file;
+}
+
 // GetToken() accesses tokens from the tokenList that is populated when a 
-// lexer object is instantiated
+// lexer object is instantiated, or from the ring in STREAMING mode
 Token LexicalAnalyzer::GetToken()
 {
+    if (mode == STREAMING) {
+        Fill(1);
+        if (index == scanned)
+            return EndOfFileToken();
+        return ring[index++ % RING_SIZE];
+    }
+
+    if (mode == PIPELINED) {
+        if (Wait(1) == index)
+            return EndOfFileToken();
+        Token token = pipe[index++ % PIPE_SIZE];
+        if (index - RING_SIZE > released.load(memory_order_relaxed))
+            released.store(index - RING_SIZE, memory_order_release);
+        return token;
+    }
+
     Token token;
     if (index == static_cast<int>(tokenList.size())){       // return end of file if
-        token.lexeme = "";                // index is too large
-        token.line_no = line_no;
-        token.token_type = END_OF_FILE;
+        token = EndOfFileToken();         // index is too large
     }
     else{
         token = tokenList[index];
@@ -173,49 +250,75 @@ void LexicalAnalyzer::UngetToken(int howMany)
 {
     if (howMany <= 0)
     {
-        cout << "LexicalAnalyzer:UngetToken:Error: non positive argument\n";
-        exit(-1);
+        *error_out
+            << "LexicalAnalyzer:UngetToken:Error: non positive argument\n";
+        Exit(-1);
     }
 
     index = index - howMany; // update index
-    if (index < 0)           // and panic if resulting index is negative
+    if (index < 0 ||         // and panic if resulting index is negative
+        (mode == STREAMING && index < scanned - RING_SIZE) || // or dropped
+        (mode == PIPELINED && index < released))
     {
-        cout << "LexicalAnalyzer:UngetToken:Error: large  argument\n";
-        exit(-1);
+        *error_out << "LexicalAnalyzer:UngetToken:Error: large  argument\n";
+        Exit(-1);
     }
 }
 
-// peek requires that the argument "howFar" be positive.
-Token LexicalAnalyzer::peek(int howFar)
+// peek requires that the argument "howFar" be positive. The returned
+// reference is valid until the next call to GetToken().
+const Token& LexicalAnalyzer::peek(int howFar)
 {
     if (howFar <= 0) {      // peeking backward or in place is not allowed
-        cout << "LexicalAnalyzer:peek:Error: non positive argument\n";
-        exit(-1);
+        *error_out << "LexicalAnalyzer:peek:Error: non positive argument\n";
+        Exit(-1);
+    }
+
+    if (mode == STREAMING) {
+        if (howFar >= RING_SIZE) { // only RING_SIZE - 1 tokens are kept ahead
+            *error_out
+                << "LexicalAnalyzer:peek:Error: argument exceeds lookahead\n";
+            Exit(-1);
+        }
+        Fill(howFar);
+        if (index + howFar > scanned)
+            return EndOfFileToken();
+        return ring[(index + howFar - 1) % RING_SIZE];
+    }
+
+    if (mode == PIPELINED) {
+        if (howFar > PIPE_SIZE - RING_SIZE) {
+            *error_out
+                << "LexicalAnalyzer:peek:Error: argument exceeds lookahead\n";
+            Exit(-1);
+        }
+        if (Wait(howFar) < index + howFar)
+            return EndOfFileToken();
+        return pipe[(index + howFar - 1) % PIPE_SIZE];
     }
 
     int peekIndex = index + howFar - 1;
     if (peekIndex > static_cast<int>(tokenList.size()-1)) { // if peeking too far
-        Token token;                        // return END_OF_FILE
-        token.lexeme = "";
-        token.line_no = line_no;
-        token.token_type = END_OF_FILE;
-        return token;
+        return EndOfFileToken();            // return END_OF_FILE
     } else
         return tokenList[peekIndex];
 }
 
 Token LexicalAnalyzer::GetTokenMain()
 {
-    char c;
-
     SkipSpace();
-    tmp.lexeme = "";
+    tmp.length = 0;
+    tmp.value = 0;
+    tmp.symbol = -1;
     tmp.line_no = line_no;
     tmp.token_type = END_OF_FILE;
-    if (!input.EndOfInput())
-        input.GetChar(c);
-    else
+
+    const char* p = input.Position();
+    const char* end = input.End();
+    if (p == end)
         return tmp;
+    char c = *p;
+    input.Seek(p + 1);
     switch (c) {
         case '+':   tmp.token_type = PLUS;      return tmp;
         case '-':   tmp.token_type = MINUS;     return tmp;
@@ -231,15 +334,13 @@ Token LexicalAnalyzer::GetTokenMain()
         case '{':   tmp.token_type = LBRACE;    return tmp;
         case '}':   tmp.token_type = RBRACE;    return tmp;
         default:
-            if (isdigit(c)) {
-                input.UngetChar(c);
+            if (IsClass(c, CC_DIGIT)) {
+                input.Seek(p);
                 return ScanNumber();
-            } else if (isalpha(c)) {
-                input.UngetChar(c);
+            } else if (IsClass(c, CC_ALPHA)) {
+                input.Seek(p);
                 return ScanIdOrKeyword();
-            } else if (input.EndOfInput())
-                tmp.token_type = END_OF_FILE;
-            else
+            } else
                 tmp.token_type = ERROR;
 
             return tmp;
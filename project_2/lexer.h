@@ -8,8 +8,12 @@
 
 #include <vector>
 #include <string>
+#include <ostream>
+#include <atomic>
+#include <thread>
 
 #include "inputbuf.h"
+#include "symbol.h"
 
 // ------- token types -------------------
 
@@ -20,32 +24,82 @@ typedef enum { END_OF_FILE = 0,
     DOT, NUM, ID, ERROR
 } TokenType;
 
+// ------- lexer modes -------------------
+//
+// PRETOKENIZE scans the whole input in the constructor. STREAMING scans
+// tokens on demand and keeps only the last RING_SIZE tokens, so peek() can
+// look at most RING_SIZE - 1 tokens ahead. PIPELINED scans on a thread of
+// its own while the parser runs and hands tokens over through a lock-free
+// single-producer single-consumer ring of PIPE_SIZE tokens; the last
+// RING_SIZE tokens read stay in the ring for UngetToken().
+
+typedef enum { PRETOKENIZE = 0, STREAMING, PIPELINED } LexerMode;
+
+#define RING_SIZE 4
+#define PIPE_SIZE 4096
+
+// A token is a small value type. Its lexeme is not copied: text points into
+// the input buffer and stays valid for the lifetime of the lexer. NUM tokens
+// also carry their decoded value and ID tokens the symbol their name is
+// interned as in the lexer's SymbolTable.
 class Token {
   public:
     void Print();
+    std::string lexeme() const { return std::string(text, length); }
+    bool SameLexeme(const Token& other) const;
 
-    std::string lexeme;
+    const char* text = "";
+    int length = 0;
     TokenType token_type;
     int line_no;
+    int value = 0;
+    int symbol = -1;
 };
 
 class LexicalAnalyzer {
   public:
     Token GetToken();
     void UngetToken(int);
-    Token peek(int);
+    const Token& peek(int);
     LexicalAnalyzer();
+    ~LexicalAnalyzer();
+
+    static void SetMode(LexerMode);
+
+    // Where the errors of peek() and UngetToken() go, cout unless the lexer
+    // belongs to a program that writes its output elsewhere
+    void SetErrorOutput(std::ostream& out) { error_out = &out; }
 
   private:
+    static LexerMode default_mode;
+
+    LexerMode mode;
+    std::ostream* error_out;
     std::vector<Token> tokenList;
+    Token ring[RING_SIZE];
+    int scanned;
+    bool scanned_all;
+    Token end_of_file;
+    std::vector<Token> pipe;
+    std::atomic<int> produced{0};   // tokens the producer has put in pipe
+    std::atomic<int> released{0};   // tokens the producer may overwrite
+    std::atomic<bool> produced_all{false};
+    std::atomic<bool> stopping{false};
+    std::thread producer;
+    void Produce();
+    int Wait(int);
+    void Fill(int);
+    const Token& EndOfFileToken();
     Token GetTokenMain();
     int line_no;
     int index;
     Token tmp;
     InputBuffer input;
+    SymbolTable symbols;
+    bool intern;
 
     bool SkipSpace();
-    int FindKeywordIndex(std::string);
+    int FindKeywordIndex(const char*, int);
     Token ScanIdOrKeyword();
     Token ScanNumber();
 };
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Work-stealing thread pool.
+ */
+#include "pool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(int threads)
+    : queued(0), unfinished(0), next(0), stopping(false)
+{
+    if (threads <= 0)
+        threads = thread::hardware_concurrency();
+    if (threads <= 0)
+        threads = 1;
+    for (int i = 0; i < threads; i++)
+        queues.push_back(unique_ptr<Queue>(new Queue));
+    for (int i = 0; i < threads; i++)
+        workers.push_back(thread(&ThreadPool::Work, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+}
+
+void ThreadPool::Submit(function<void()> task)
+{
+    Queue* queue;
+    {
+        lock_guard<mutex> guard(lock);
+        queue = queues[next++ % queues.size()].get();
+        unfinished++;
+    }
+    {
+        lock_guard<mutex> guard(queue->lock);
+        queue->tasks.push_back(move(task));
+    }
+    {
+        lock_guard<mutex> guard(lock);
+        queued++;
+    }
+    work_ready.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+    unique_lock<mutex> guard(lock);
+    all_done.wait(guard, [this] { return unfinished == 0; });
+}
+
+// Takes a task from the back of the worker's own deque or, failing that,
+// from the front of another one
+bool ThreadPool::Take(int self, function<void()>& task)
+{
+    int n = (int) queues.size();
+    for (int i = 0; i < n; i++) {
+        Queue& queue = *queues[(self + i) % n];
+        lock_guard<mutex> guard(queue.lock);
+        if (queue.tasks.empty())
+            continue;
+        if (i == 0) {
+            task = move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::Work(int self)
+{
+    function<void()> task;
+    for (;;) {
+        {
+            unique_lock<mutex> guard(lock);
+            work_ready.wait(guard, [this] { return queued > 0 || stopping; });
+            if (queued == 0)
+                return;
+            queued--;
+        }
+
+        // There are never fewer tasks in the deques than reservations, so a
+        // search that comes up empty only raced with other workers
+        while (!Take(self, task))
+            this_thread::yield();
+        task();
+        task = nullptr;
+
+        lock_guard<mutex> guard(lock);
+        if (--unfinished == 0)
+            all_done.notify_all();
+    }
+}
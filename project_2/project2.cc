@@ -6,15 +6,45 @@
 #include <iostream>
 #include <cstdio>
 #include <cstdlib>
+#include <string>
 #include "execute.h"
 #include "tasks.h"
+#include "batch.h"
 
 using namespace std;
 
+static int task;
+
+static void run_task(ostream& out)
+{
+    Context context(out);
+
+    switch (task) {
+        case 1: // Task 1
+		parse_and_generate_AST(context);
+            break;
+
+        case 2: // Task 2
+		parse_and_type_check(context);
+            break;
+
+        case 3: instNode* code;
+		code = parse_and_generate_statement_list(context);
+		out << "1234567890" << "testing" << "testing" << endl;
+		execute_inst_list(code, context);
+		out << "1234567890" << "testing" << "testing" << endl;
+            break;
+
+        default:
+            out << "Error: unrecognized task number " << task << "\n";
+            break;
+    }
+}
 
 int main (int argc, char* argv[])
 {
-    int task;
+    bool batch = false;
+    int jobs = 1;
 
     if (argc < 2)
     {
@@ -28,28 +58,37 @@ int main (int argc, char* argv[])
      */
 
     task = atoi(argv[1]);
-    
-
-    switch (task) {
-        case 1: // Task 1
-		parse_and_generate_AST();
-            break;
 
-        case 2: // Task 2
-		parse_and_type_check();
-            break;
+    // Options after the task number:
+    //   --stream     scan tokens on demand instead of tokenizing the whole
+    //                input before parsing starts
+    //   --pipeline   scan tokens on a separate thread while parsing
+    //   --batch      run every program of a batch (see batch.h)
+    //   --jobs N     run a batch N programs at a time, one per core if N is
+    //                0 (implies --batch)
+    for (int i = 2; i < argc; i++) {
+        string option = argv[i];
+        if (option == "--stream") {
+            LexicalAnalyzer::SetMode(STREAMING);
+        } else if (option == "--pipeline") {
+            LexicalAnalyzer::SetMode(PIPELINED);
+        } else if (option == "--batch") {
+            batch = true;
+        } else if (option == "--jobs" && i + 1 < argc) {
+            batch = true;
+            jobs = atoi(argv[++i]);
+        } else {
+            cout << "Error: unrecognized option " << option << "\n";
+            return 1;
+        }
+    }
 
-        case 3: instNode* code;
-		code = parse_and_generate_statement_list();
-		cout << "1234567890" << "testing" << "testing" << endl;
-		execute_inst_list(code);
-		cout << "1234567890" << "testing" << "testing" << endl;
-            break;
 
-        default:
-            cout << "Error: unrecognized task number " << task << "\n";
-            break;
+    if (batch) {
+        RunBatch(run_task, jobs);
+        return 0;
     }
+    run_task(cout);
     return 0;
 }
 
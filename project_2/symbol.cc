@@ -0,0 +1,60 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Interning of identifiers.
+ */
+#include <cstring>
+
+#include "symbol.h"
+
+using namespace std;
+
+#define INITIAL_SLOTS 64
+
+// FNV-1a
+static unsigned Hash(const char* text, int length)
+{
+    unsigned h = 2166136261u;
+    for (int i = 0; i < length; i++)
+        h = (h ^ (unsigned char) text[i]) * 16777619u;
+    return h;
+}
+
+SymbolTable::SymbolTable() : slots(INITIAL_SLOTS, -1)
+{
+}
+
+int SymbolTable::Intern(const char* text, int length)
+{
+    unsigned h = Hash(text, length);
+    size_t mask = slots.size() - 1;
+    size_t i = h & mask;
+
+    while (slots[i] != -1) {
+        int symbol = slots[i];
+        if (hashes[symbol] == h && (int) names[symbol].size() == length &&
+            memcmp(names[symbol].data(), text, length) == 0)
+            return symbol;
+        i = (i + 1) & mask;
+    }
+
+    int symbol = (int) names.size();
+    names.push_back(string(text, length));
+    hashes.push_back(h);
+    slots[i] = symbol;
+    if (names.size() * 2 > slots.size())    // keep the load factor below 1/2
+        Grow();
+    return symbol;
+}
+
+void SymbolTable::Grow()
+{
+    slots.assign(slots.size() * 2, -1);
+    size_t mask = slots.size() - 1;
+    for (size_t symbol = 0; symbol < names.size(); symbol++) {
+        size_t i = hashes[symbol] & mask;
+        while (slots[i] != -1)
+            i = (i + 1) & mask;
+        slots[i] = (int) symbol;
+    }
+}
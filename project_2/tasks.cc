@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <mutex>
 #include <queue>
 #include <stack>
 #include <string>
@@ -11,33 +12,46 @@
 #include <utility>
 #include <vector>
 
+#include "batch.h"   // NOLINT
 #include "execute.h" // NOLINT
 
-extern long mem[MEMSIZE]; // NOLINT
-
+// The grammar and precedence tables are the same for every program. They
+// are filled once by fill_tables() and only read afterwards, through const
+// references, so parsers on different threads can share them.
 std::unordered_map<std::string, std::unordered_map<std::string, int>>
     operator_precedence_table;
 std::unordered_map<std::string, std::pair<std::string, std::vector<int>>>
     grammar_expression_to_string_table;
 std::unordered_set<std::string> valid_code_grammar_strings;
-std::vector<struct program_graph_node *> program_statement_table;
-std::unordered_set<std::string> scalar_variables;
-std::unordered_set<std::string> array_variables;
 std::unordered_set<std::string> valid_statement_grammar_strings;
-std::vector<int> typelino;
-std::vector<int> assignlino;
-
-int memory_position = 0;
-std::unordered_map<std::string, int> variable_location_in_memory;
 std::vector<std::string> all_grammar_keys_for_comparison = {
     "END_OF_FILE", "SCALAR", "ARRAY", "OUTPUT", "PLUS", "MINUS", "DIV",
     "MULT", "EQUAL", "SEMICOLON", "LBRAC", "RBRAC", "LPAREN", "RPAREN",
     "LBRACE", "RBRACE", "DOT", "NUM", "ID", "ERROR"};
 
+// Entry of a table indexed by symbol, growing the table when needed
+template <typename T>
+static typename std::vector<T>::reference symbol_entry(std::vector<T> &table,
+                                                        const Token &token)
+{
+    if (token.symbol >= static_cast<int>(table.size()))
+    {
+        table.resize(token.symbol + 1);
+    }
+    return table[token.symbol];
+}
+
+static bool is_declared(const std::vector<bool> &table, const Token &token)
+{
+    return token.symbol >= 0 &&
+           token.symbol < static_cast<int>(table.size()) &&
+           table[token.symbol];
+}
+
 void Parser::syntax_error()
 {
-    std::cout << "SNYATX EORRR !!!";
-    exit(1);
+    context.out << "SNYATX EORRR !!!";
+    Exit(1);
 }
 
 Token Parser::expect(TokenType expected_type)
@@ -50,7 +64,7 @@ Token Parser::expect(TokenType expected_type)
     return t;
 }
 
-Parser::Parser()
+static void fill_tables()
 {
     grammar_expression_to_string_table["ID"] = make_pair("", std::vector<int>{0});
     grammar_expression_to_string_table["NUM"] =
@@ -249,6 +263,26 @@ Parser::Parser()
     operator_precedence_table["END_OF_FILE"]["END_OF_FILE"] = 4;
 }
 
+// A parser compiles one program into the memory of its context
+Parser::Parser(Context &context) : context(context)
+{
+    lexer.SetErrorOutput(context.out);
+    static std::once_flag tables_filled;
+    std::call_once(tables_filled, fill_tables);
+}
+
+struct program_graph_node *Parser::new_graph_node()
+{
+    graph_nodes.emplace_back(new program_graph_node);
+    return graph_nodes.back().get();
+}
+
+struct stack_of_graph_nodes *Parser::new_stack_node()
+{
+    stack_nodes.emplace_back(new stack_of_graph_nodes);
+    return stack_nodes.back().get();
+}
+
 void Parser::parse_program()
 {
     parse_declaration_section();
@@ -280,23 +314,23 @@ void Parser::parse_id_list(int id_type)
 
     if (id_type == 0)
     {
-        variable_location_in_memory[token1.lexeme] = memory_position;
+        symbol_entry(variable_location_in_memory, token1) = memory_position;
         int temp = 0;
 
         while (temp < 10)
         {
-            mem[memory_position + temp] = 0;
+            context.mem[memory_position + temp] = 0;
             temp++;
         }
         memory_position += 10;
-        array_variables.insert(token1.lexeme);
+        symbol_entry(array_variables, token1) = true;
     }
     else
     {
-        variable_location_in_memory[token1.lexeme] = memory_position;
-        mem[memory_position] = 0;
+        symbol_entry(variable_location_in_memory, token1) = memory_position;
+        context.mem[memory_position] = 0;
         memory_position++;
-        scalar_variables.insert(token1.lexeme);
+        symbol_entry(scalar_variables, token1) = true;
     }
 
     Token token2;
@@ -365,7 +399,7 @@ struct program_graph_node *Parser::parse_statement()
 
 struct program_graph_node *Parser::parse_assignment_statement()
 {
-    struct program_graph_node *complete_assignment_tree = new program_graph_node;
+    struct program_graph_node *complete_assignment_tree = new_graph_node();
     complete_assignment_tree->operation = "=";
 
     struct program_graph_node *left_hand_side;
@@ -409,7 +443,7 @@ struct program_graph_node *Parser::parse_variable_access(
     token2 = lexer.peek(1);
     token3 = lexer.peek(2);
 
-    struct program_graph_node *variable_tree = new program_graph_node;
+    struct program_graph_node *variable_tree = new_graph_node();
 
     if (token2.token_type == LBRAC && token3.token_type == DOT)
     {
@@ -418,7 +452,7 @@ struct program_graph_node *Parser::parse_variable_access(
         expect(RBRAC);
         variable_tree->operation = "[.]";
 
-        struct program_graph_node *id_tree = new program_graph_node;
+        struct program_graph_node *id_tree = new_graph_node();
         id_tree->token_term = token1;
         variable_tree->lhs = id_tree;
     }
@@ -427,7 +461,7 @@ struct program_graph_node *Parser::parse_variable_access(
               token3.token_type == LPAREN))
     {
         variable_tree->operation = "[]";
-        struct program_graph_node *id_tree = new program_graph_node;
+        struct program_graph_node *id_tree = new_graph_node();
         id_tree->token_term = token1;
         variable_tree->lhs = id_tree;
 
@@ -465,7 +499,6 @@ Token Parser::check_end(int check_assignment_state)
     token1 = lexer.peek(1);
     token2 = lexer.peek(2);
 
-    temp_token.lexeme = "";
     temp_token.token_type = END_OF_FILE;
 
     if (check_assignment_state == 0)
@@ -525,13 +558,17 @@ struct stack_of_graph_nodes *Parser::find_top_token(
 struct program_graph_node *Parser::parse_expression(
     int check_assignment_state)
 {
+    // The shared tables, read through const references so that a lookup can
+    // never insert into them
+    const auto &precedence = operator_precedence_table;
+    const auto &grammar = grammar_expression_to_string_table;
+
     std::stack<struct stack_of_graph_nodes *> stk;
-    struct stack_of_graph_nodes *temp_stack = new stack_of_graph_nodes;
+    struct stack_of_graph_nodes *temp_stack = new_stack_node();
     Token token;
     std::string buildexpr = "";
 
     temp_stack->statement_type = "TERM";
-    token.lexeme = "";
     token.token_type = END_OF_FILE;
     temp_stack->token_term = token;
     stk.push(temp_stack);
@@ -550,26 +587,26 @@ struct program_graph_node *Parser::parse_expression(
         syntax_error();
     }
 
-    while (operator_precedence_table[first][second] != 4)
+    while (precedence.at(first).at(second) != 4)
     {
         std::vector<struct stack_of_graph_nodes *> stk1;
 
-        if (operator_precedence_table[first][second] == 1 ||
-            operator_precedence_table[first][second] == 2)
+        if (precedence.at(first).at(second) == 1 ||
+            precedence.at(first).at(second) == 2)
         {
             Token put = lexer.GetToken();
-            struct stack_of_graph_nodes *new_temp = new stack_of_graph_nodes;
+            struct stack_of_graph_nodes *new_temp = new_stack_node();
             new_temp->statement_type = "TERM";
             new_temp->token_term = put;
             stk.push(new_temp);
         }
-        else if (operator_precedence_table[first][second] == 0)
+        else if (precedence.at(first).at(second) == 0)
         {
             std::string buildexpr = "";
 
-            while (operator_precedence_table[first][second] != 1)
+            while (precedence.at(first).at(second) != 1)
             {
-                if (operator_precedence_table[first][second] == 3)
+                if (precedence.at(first).at(second) == 3)
                     syntax_error();
 
                 while (stk.top()->statement_type != "TERM")
@@ -603,15 +640,15 @@ struct program_graph_node *Parser::parse_expression(
                 syntax_error();
             }
 
-            struct program_graph_node *expr = new program_graph_node;
-            std::pair<std::string, std::vector<int>> build =
-                grammar_expression_to_string_table[buildexpr];
+            struct program_graph_node *expr = new_graph_node();
+            const std::pair<std::string, std::vector<int>> &build =
+                grammar.at(buildexpr);
             expr->operation = build.first;
 
             if (buildexpr == "ID" || buildexpr == "NUM")
             {
                 expr->token_term = stk1[build.second[0]]->token_term;
-                struct stack_of_graph_nodes *new_temp = new stack_of_graph_nodes;
+                struct stack_of_graph_nodes *new_temp = new_stack_node();
                 new_temp->statement_type = "EXPR";
                 new_temp->expr = expr;
                 stk.push(new_temp);
@@ -632,13 +669,13 @@ struct program_graph_node *Parser::parse_expression(
                     expr->lhs = stk1[build.second[0]]->expr;
                 }
 
-                struct stack_of_graph_nodes *new_temp = new stack_of_graph_nodes;
+                struct stack_of_graph_nodes *new_temp = new_stack_node();
                 new_temp->statement_type = "EXPR";
                 new_temp->expr = expr;
                 stk.push(new_temp);
             }
         }
-        else if (operator_precedence_table[first][second] == 3)
+        else if (precedence.at(first).at(second) == 3)
         {
             syntax_error();
         }
@@ -690,13 +727,11 @@ void Parser::breadth_first_search(struct program_graph_node *first_graph_node,
                 }
                 else
                 {
-                    if (scalar_variables.find(temp_node->token_term.lexeme) !=
-                        scalar_variables.end())
+                    if (is_declared(scalar_variables, temp_node->token_term))
                     {
                         temp_node->statement_type = "SCALAR";
                     }
-                    else if (array_variables.find(temp_node->token_term.lexeme) !=
-                             array_variables.end())
+                    else if (is_declared(array_variables, temp_node->token_term))
                     {
                         temp_node->statement_type = "ARRAYDECL";
                     }
@@ -710,17 +745,17 @@ void Parser::breadth_first_search(struct program_graph_node *first_graph_node,
                 {
                     if (first)
                     {
-                        std::cout << all_grammar_keys_for_comparison[temp_node->token_term
+                        context.out << all_grammar_keys_for_comparison[temp_node->token_term
                                                                          .token_type]
-                                  << " \"" << temp_node->token_term.lexeme << "\"";
+                                  << " \"" << temp_node->token_term.lexeme() << "\"";
                         first = false;
                     }
                     else
                     {
-                        std::cout << " "
+                        context.out << " "
                                   << all_grammar_keys_for_comparison[temp_node->token_term
                                                                          .token_type]
-                                  << " \"" << temp_node->token_term.lexeme << "\"";
+                                  << " \"" << temp_node->token_term.lexeme() << "\"";
                     }
                 }
             }
@@ -730,12 +765,12 @@ void Parser::breadth_first_search(struct program_graph_node *first_graph_node,
                 {
                     if (first)
                     {
-                        std::cout << temp_node->operation;
+                        context.out << temp_node->operation;
                         first = false;
                     }
                     else
                     {
-                        std::cout << " " << temp_node->operation;
+                        context.out << " " << temp_node->operation;
                     }
                 }
 
@@ -751,7 +786,7 @@ void Parser::breadth_first_search(struct program_graph_node *first_graph_node,
             queue_size--;
         }
     }
-    std::cout << std::endl;
+    context.out << std::endl;
 }
 
 void Parser::task1()
@@ -916,53 +951,53 @@ void Parser::task2()
     }
     if (typelino.size() > 0)
     {
-        std::cout << "Disappointing expression type error :(" << std::endl;
-        std::cout << std::endl;
+        context.out << "Disappointing expression type error :(" << std::endl;
+        context.out << std::endl;
         for (int i = 0; i < typelino.size(); i++)
         {
-            std::cout << "Line " << typelino[i] << std::endl;
+            context.out << "Line " << typelino[i] << std::endl;
         }
-        exit(1);
+        Exit(1);
     }
     else
     {
         if (assignlino.size() > 0)
         {
-            std::cout << "The following assignment(s) is/are invalid :(" << std::endl;
-            std::cout << std::endl;
+            context.out << "The following assignment(s) is/are invalid :(" << std::endl;
+            context.out << std::endl;
             for (int i = 0; i < assignlino.size(); i++)
             {
-                std::cout << "Line " << assignlino[i] << std::endl;
+                context.out << "Line " << assignlino[i] << std::endl;
             }
-            exit(1);
+            Exit(1);
         }
         else
         {
-            std::cout << "Amazing! No type errors here :)" << std::endl;
+            context.out << "Amazing! No type errors here :)" << std::endl;
         }
     }
 }
 
 // Task 1
-void parse_and_generate_AST()
+void parse_and_generate_AST(Context &context)
 {
-    Parser p;
+    Parser p(context);
     p.parse_program();
     p.task1();
 }
 
 // Task 2
-void parse_and_type_check()
+void parse_and_type_check(Context &context)
 {
-    Parser p;
+    Parser p(context);
     p.parse_program();
     p.task2();
 }
 
 // Task 3
-instNode *parse_and_generate_statement_list()
+instNode *parse_and_generate_statement_list(Context &context)
 {
-    std::cout << "3" << std::endl;
+    context.out << "3" << std::endl;
 
     // The following is the hardcoded statement list
     // generated for a specific program
@@ -999,7 +1034,7 @@ instNode *parse_and_generate_statement_list()
     //                              4 + value of 3 (computation is not done at
     //                              compile time)
     //
-    instNode *i01 = new instNode();
+    instNode *i01 = context.new_instruction();
     i01->lhsat = DIRECT;
     i01->lhs = 0;             // a
     i01->iType = ASSIGN_INST; // =
@@ -1007,7 +1042,7 @@ instNode *parse_and_generate_statement_list()
     i01->op1 = 1;        // 1
     i01->oper = OP_NOOP; // no operator
 
-    instNode *i02 = new instNode();
+    instNode *i02 = context.new_instruction();
     i02->lhsat = DIRECT;
     i02->lhs = 1;             // b
     i02->iType = ASSIGN_INST; // =
@@ -1017,7 +1052,7 @@ instNode *parse_and_generate_statement_list()
 
     i01->next = i02;
 
-    instNode *i03 = new instNode();
+    instNode *i03 = context.new_instruction();
     i03->lhsat = DIRECT;
     i03->lhs = 2;             // c
     i03->iType = ASSIGN_INST; // =
@@ -1027,7 +1062,7 @@ instNode *parse_and_generate_statement_list()
 
     i02->next = i03;
 
-    instNode *i1 = new instNode();
+    instNode *i1 = context.new_instruction();
     i1->lhsat = DIRECT;
     i1->lhs = 34;            // t1
     i1->iType = ASSIGN_INST; // =
@@ -1039,7 +1074,7 @@ instNode *parse_and_generate_statement_list()
 
     i03->next = i1;
 
-    instNode *i2 = new instNode();
+    instNode *i2 = context.new_instruction();
     i2->lhsat = DIRECT;
     i2->lhs = 35;            // t2
     i2->iType = ASSIGN_INST; // =
@@ -1051,7 +1086,7 @@ instNode *parse_and_generate_statement_list()
 
     i1->next = i2;
 
-    instNode *i3 = new instNode();
+    instNode *i3 = context.new_instruction();
     i3->lhsat = DIRECT;
     i3->lhs = 36;            // t3
     i3->iType = ASSIGN_INST; // =
@@ -1063,7 +1098,7 @@ instNode *parse_and_generate_statement_list()
 
     i2->next = i3; // i3 should be after i1 and i2
 
-    instNode *i4 = new instNode();
+    instNode *i4 = context.new_instruction();
     i4->lhsat = DIRECT;
     i4->lhs = 3;             // d
     i4->iType = ASSIGN_INST; // =
@@ -1073,14 +1108,14 @@ instNode *parse_and_generate_statement_list()
 
     i3->next = i4;
 
-    instNode *i5 = new instNode();
+    instNode *i5 = context.new_instruction();
     i5->iType = OUTPUT_INST; // OUTPUT
     i5->op1at = DIRECT;
     i5->op1 = 3; // d
 
     i4->next = i5;
 
-    instNode *i6 = new instNode();
+    instNode *i6 = context.new_instruction();
     i6->lhsat = DIRECT;
     i6->lhs = 37;            // t4
     i6->iType = ASSIGN_INST; // =
@@ -1091,7 +1126,7 @@ instNode *parse_and_generate_statement_list()
     i6->op2 = 1; // b
     i5->next = i6;
 
-    instNode *i7 = new instNode();
+    instNode *i7 = context.new_instruction();
     i7->lhsat = DIRECT;
     i7->lhs = 38;            // t5
     i7->iType = ASSIGN_INST; // =
@@ -1104,7 +1139,7 @@ instNode *parse_and_generate_statement_list()
 
     i6->next = i7;
 
-    instNode *i8 = new instNode();
+    instNode *i8 = context.new_instruction();
     i8->lhsat = INDIRECT;
     i8->lhs = 38;            // x[a+b]
     i8->iType = ASSIGN_INST; // =
@@ -1114,7 +1149,7 @@ instNode *parse_and_generate_statement_list()
 
     i7->next = i8;
 
-    instNode *i9 = new instNode();
+    instNode *i9 = context.new_instruction();
     i9->lhsat = DIRECT;
     i9->lhs = 39;            // t6 will contain address of x[3]
     i9->iType = ASSIGN_INST; // =
@@ -1127,7 +1162,7 @@ instNode *parse_and_generate_statement_list()
 
     i8->next = i9;
 
-    instNode *i10 = new instNode();
+    instNode *i10 = context.new_instruction();
     i10->iType = OUTPUT_INST; // OUTPUT
     i10->op1at = INDIRECT;
     i10->op1 = 39; // x[3] by providing its
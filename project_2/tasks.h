@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <memory>
 #include <stack>
 #include <string>
 #include <unordered_map>
@@ -34,12 +35,32 @@ struct program_graph_node
 class Parser
 {
 private:
+    Context &context;
     LexicalAnalyzer lexer;
+
+    // Per-program tables. scalar_variables, array_variables and
+    // variable_location_in_memory are indexed by the symbol the lexer
+    // interned the variable name as.
+    std::vector<struct program_graph_node *> program_statement_table;
+    std::vector<bool> scalar_variables;
+    std::vector<bool> array_variables;
+    std::vector<int> typelino;
+    std::vector<int> assignlino;
+    int memory_position = 0;
+    std::vector<int> variable_location_in_memory;
+
+    // The nodes of the program graph and of the expression stacks, freed
+    // with the parser so that a batch does not keep every program's nodes
+    std::vector<std::unique_ptr<program_graph_node> > graph_nodes;
+    std::vector<std::unique_ptr<stack_of_graph_nodes> > stack_nodes;
+    struct program_graph_node *new_graph_node();
+    struct stack_of_graph_nodes *new_stack_node();
+
     void syntax_error();
     Token expect(TokenType expected_type);
 
 public:
-    Parser();
+    explicit Parser(Context &context);
     void parse_program();
     void parse_declaration_section();
     void parse_scalar_declaration_section();
@@ -67,8 +88,8 @@ public:
     instNode *task3();
 };
 
-void parse_and_generate_AST();
-void parse_and_type_check();
-instNode *parse_and_generate_statement_list();
+void parse_and_generate_AST(Context &context);
+void parse_and_type_check(Context &context);
+instNode *parse_and_generate_statement_list(Context &context);
 
 #endif // TASKS_H_  NOLINT
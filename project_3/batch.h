@@ -0,0 +1,47 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Batch mode: many programs per process.
+ */
+#ifndef __BATCH__H__
+#define __BATCH__H__
+
+// ------- batch mode -------------------
+//
+// In batch mode standard input holds a sequence of programs, each ended by a
+// line containing only BATCH_DELIMITER (the delimiter after the last program
+// may be left out). Every program is compiled and run on its own and its
+// output is followed by a report line
+//
+//     %% program <n>: ok
+//     %% program <n>: error <status>
+//
+// An error that would end the process ends only the current program, and so
+// does an exception run() lets escape: its message is printed as
+// "Error: <what>" and the program ends with status 1.
+//
+// Programs can also be run on a pool of threads. Each one then writes its
+// output to a buffer of its own, and the outputs and report lines are
+// printed in input order once the whole batch has run.
+
+#include <ostream>
+
+#define BATCH_DELIMITER "%%"
+
+// Thrown by Exit() in batch mode
+struct ProgramExit {
+    int status;
+};
+
+// Ends the current program: exit(status) normally, throws ProgramExit in
+// batch mode
+void Exit(int status);
+
+// Calls run(out) once for every program on standard input, with lexers
+// created by run() reading that program only. Programs are run jobs at a
+// time (jobs == 0: one per core), so run() must keep all of its state in
+// objects of its own and write the program's output to out. Returns the
+// number of programs that ended in an error.
+int RunBatch(void (*run)(std::ostream& out), int jobs);
+
+#endif  //__BATCH__H__
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Microbenchmark for keyword recognition on identifier-heavy input. The
+ * FindKeywordIndex() the lexer had before keyword.h is timed against the
+ * one it has now on the same identifiers.
+ *
+ * Build and run from project_3:
+ *
+ *     g++ -std=c++11 -O2 bench/keyword_bench.cc -o keyword_bench
+ *     ./keyword_bench [identifiers] [rounds]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../keyword.h"
+
+using namespace std;
+
+// LexicalAnalyzer::FindKeywordIndex() before keyword.h, as it was. The
+// lexer called it with the std::string lexeme of the token, by value.
+static int OldFindKeywordIndex(string s)
+{
+    string keyword[] = { "VAR", "FOR", "IF", "WHILE", "SWITCH", "CASE", "DEFAULT", "input", "output", "ARRAY" };
+    for (int i = 0; i < KEYWORDS_COUNT; i++) {
+        if (s == keyword[i]) {
+            return i + 1;
+        }
+    }
+    return -1;
+}
+
+// LexicalAnalyzer::FindKeywordIndex() now, on the lexeme in the input
+static int NewFindKeywordIndex(const string& id)
+{
+    int i = KeywordLookup(id.data(), (int) id.size());
+    return i == -1 ? -1 : i + 1;
+}
+
+// One identifier in five is a keyword, the rest are names of 1 to 12
+// letters and digits starting with a letter, as in the test programs
+static vector<string> MakeIdentifiers(int count)
+{
+    static const char alnum[] =
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    vector<string> ids;
+    srand(340);
+    for (int i = 0; i < count; i++) {
+        if (rand() % 5 == 0) {
+            ids.push_back(keyword[rand() % KEYWORDS_COUNT]);
+            continue;
+        }
+        string id(1, alnum[rand() % 52]);
+        int length = 1 + rand() % 12;
+        while ((int) id.size() < length)
+            id += alnum[rand() % 62];
+        ids.push_back(id);
+    }
+    return ids;
+}
+
+template <typename Lookup>
+static double Run(const char* name, Lookup lookup, const vector<string>& ids,
+                  int rounds, long* checksum)
+{
+    long sum = 0;
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++)
+        for (size_t i = 0; i < ids.size(); i++)
+            sum += lookup(ids[i]);
+    auto stop = chrono::steady_clock::now();
+
+    double ns = chrono::duration<double, nano>(stop - start).count();
+    double per_lookup = ns / ((double) ids.size() * rounds);
+    printf("%-8s %8.2f ns/identifier  %8.1f M identifiers/s\n", name,
+           per_lookup, 1000.0 / per_lookup);
+    *checksum = sum;
+    return per_lookup;
+}
+
+int main(int argc, char* argv[])
+{
+    int count = argc > 1 ? atoi(argv[1]) : 100000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 100;
+    if (count <= 0 || rounds <= 0) {
+        printf("usage: %s [identifiers] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    vector<string> ids = MakeIdentifiers(count);
+    long old_sum, new_sum;
+    double before = Run("before", OldFindKeywordIndex, ids, rounds, &old_sum);
+    double after = Run("after", NewFindKeywordIndex, ids, rounds, &new_sum);
+
+    if (old_sum != new_sum) {
+        printf("mismatch: the two lookups disagree\n");
+        return 1;
+    }
+    printf("speedup  %8.2fx\n", before / after);
+    return 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Lexer throughput benchmark. For every size given on the command line (in
+ * MB, 1 to 1024) a var/for/while/switch program of that size is generated
+ * into a temporary file, standard input is pointed at it and the
+ * LexicalAnalyzer constructor and the GetToken() loop are timed on their
+ * own. Nothing is parsed or executed.
+ *
+ * Build and run from project_3 with
+ *
+ *     sh bench/run.sh [--pretokenize | --stream | --parallel] [MB ...]
+ *
+ * Without a mode all three modes are measured. PRETOKENIZE keeps every token in
+ * memory (sizeof(Token) per token), so use --stream for the largest sizes.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../lexer.h"
+
+using namespace std;
+
+#define MB (1024L * 1024L)
+
+// ------- input generator -------------------
+
+static unsigned long seed = 340;
+
+static int Random(int n)
+{
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    return (int) ((seed >> 33) % n);
+}
+
+static string Var()
+{
+    static const char* names[] = { "a", "b", "c", "i", "r", "sum", "count",
+        "x1", "y2", "total", "index", "tmp" };
+    return names[Random(12)];
+}
+
+static string Num()
+{
+    return to_string(Random(4) == 0 ? Random(100000) : Random(10));
+}
+
+static string Primary()
+{
+    return Random(3) == 0 ? Num() : Var();
+}
+
+static string Expr()
+{
+    static const char* ops[] = { " + ", " - ", " * ", " / " };
+    string e = Primary();
+    if (Random(2) == 0)
+        e += ops[Random(4)] + Primary();
+    return e;
+}
+
+static string Condition()
+{
+    static const char* relops[] = { " > ", " < ", " <> " };
+    return Primary() + relops[Random(3)] + Primary();
+}
+
+static string Statement(const string& indent)
+{
+    switch (Random(8)) {
+        case 0:  return indent + "input " + Var() + ";\n";
+        case 1:  return indent + "output " + Var() + ";\n";
+        default: return indent + Var() + " = " + Expr() + ";\n";
+    }
+}
+
+// Appends one compound statement, roughly 100 bytes of source
+static void Block(string& out)
+{
+    string v = Var();
+    switch (Random(6)) {
+        case 0:
+            out += "WHILE " + Condition() + " {\n";
+            out += Statement("\t") + Statement("\t") + "}\n";
+            break;
+        case 1:
+            out += "IF " + Condition() + " {\n";
+            out += Statement("\t") + "}\n";
+            break;
+        case 2:
+            out += "FOR (" + v + " = 0; " + v + " < " + Num() + "; " + v +
+                   " = " + v + " + 1;) {\n";
+            out += Statement("\t") + "}\n";
+            break;
+        case 3:
+            out += "SWITCH " + v + " {\n";
+            out += "\tCASE " + to_string(Random(10)) + " : {\n";
+            out += Statement("\t\t") + "\t}\n";
+            out += "\tDEFAULT : {\n" + Statement("\t\t") + "\t}\n}\n";
+            break;
+        default:
+            out += Statement("") + Statement("");
+            break;
+    }
+}
+
+// Writes a program of about "size" bytes to fd
+static void Generate(int fd, long size)
+{
+    string out = "a, b, c, i, r, sum, count, x1, y2, total, index, tmp ;\n{\n";
+    long written = 0;
+    while (written + (long) out.size() < size - 16) {
+        Block(out);
+        if (out.size() >= 1 << 20) {
+            written += write(fd, out.data(), out.size());
+            out.clear();
+        }
+    }
+    out += "}\n1 2 3 4 5\n";
+    written += write(fd, out.data(), out.size());
+}
+
+// ------- timing -------------------
+
+static double Seconds(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start)
+        .count();
+}
+
+static void Report(const char* what, long bytes, long tokens, double seconds)
+{
+    printf("  %-24s %9.3f s %10.1f MB/s %12.0f tokens/s\n", what, seconds,
+           bytes / seconds / MB, tokens / seconds);
+}
+
+// Lexes the file open on fd with a fresh lexer in the given mode
+static void Measure(int fd, long bytes, LexerMode mode)
+{
+    lseek(fd, 0, SEEK_SET);
+    dup2(fd, STDIN_FILENO);
+    LexicalAnalyzer::SetMode(mode);
+
+    auto start = chrono::steady_clock::now();
+    LexicalAnalyzer lexer;
+    double construct = Seconds(start);
+
+    long tokens = 0;
+    start = chrono::steady_clock::now();
+    while (lexer.GetToken().token_type != END_OF_FILE)
+        tokens++;
+    double loop = Seconds(start);
+
+    if (mode == PRETOKENIZE) {
+        Report("constructor", bytes, tokens, construct);
+        Report("GetToken loop", bytes, tokens, loop);
+    } else if (mode == PARALLEL) {
+        Report("parallel constructor", bytes, tokens, construct);
+    } else {
+        Report("streaming GetToken loop", bytes, tokens, construct + loop);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bool pretokenize = true;
+    bool streaming = true;
+    bool parallel = true;
+    vector<long> sizes;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--pretokenize") == 0) {
+            streaming = parallel = false;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            pretokenize = parallel = false;
+        } else if (strcmp(argv[i], "--parallel") == 0) {
+            pretokenize = streaming = false;
+        } else if (atol(argv[i]) >= 1 && atol(argv[i]) <= 1024) {
+            sizes.push_back(atol(argv[i]));
+        } else {
+            printf("usage: %s [--pretokenize | --stream | --parallel] "
+                   "[MB ...]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (sizes.empty()) {
+        sizes.push_back(1);
+        sizes.push_back(16);
+        sizes.push_back(128);
+    }
+
+    for (size_t i = 0; i < sizes.size(); i++) {
+        char path[] = "/tmp/lexer_benchXXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0) {
+            perror("mkstemp");
+            return 1;
+        }
+        unlink(path);
+        Generate(fd, sizes[i] * MB);
+        long bytes = lseek(fd, 0, SEEK_END);
+
+        printf("%ld MB program (%ld bytes)\n", sizes[i], bytes);
+        if (pretokenize)
+            Measure(fd, bytes, PRETOKENIZE);
+        if (streaming)
+            Measure(fd, bytes, STREAMING);
+        if (parallel)
+            Measure(fd, bytes, PARALLEL);
+        close(fd);
+    }
+    return 0;
+}
@@ -10,9 +10,10 @@
 #include "lexer.h"
 #include "parser.h"
 
-struct InstructionNode *parse_generate_intermediate_representation()
+struct InstructionNode *parse_generate_intermediate_representation(
+    Context &context)
 {
-    Parser parser;
+    Parser parser(context);
     struct InstructionNode *program = parser.parse_program();
     return program;
 }
@@ -8,20 +8,17 @@
 #include <cstdarg>
 #include <cctype>
 #include <cstring>
+#include <iostream>
 #include <string>
+#include "batch.h"
 #include "execute.h"
+#include "lexer.h"
 
 
 using namespace std;
 
 #define DEBUG 0     // 1 => Turn ON debugging, 0 => Turn OFF debugging
 
-int mem[1000];
-int next_available = 0;
-
-std::vector<int> inputs;
-int next_input = 0;
-
 void debug(const char* format, ...)
 {
     va_list args;
@@ -33,9 +30,10 @@ void debug(const char* format, ...)
     }
 }
 
-void execute_program(struct InstructionNode * program)
+void execute_program(struct InstructionNode * program, Context& context)
 {
     struct InstructionNode * pc = program;
+    int* mem = context.mem;
     int op1, op2, result;
 
     while(pc != NULL)
@@ -47,13 +45,13 @@ void execute_program(struct InstructionNode * program)
                 break;
             case IN:
 
-                mem[pc->input_inst.var_index] = inputs[next_input];
-                next_input++;
+                mem[pc->input_inst.var_index] =
+                    context.inputs[context.next_input];
+                context.next_input++;
                 pc = pc->next;
                 break;
             case OUT:
-                printf("%d ", mem[pc->output_inst.var_index]);
-		fflush(stdin);
+                context.out << mem[pc->output_inst.var_index] << ' ';
                 pc = pc->next;
                 break;
             case ASSIGN:
@@ -91,7 +89,7 @@ void execute_program(struct InstructionNode * program)
                 if (pc->cjmp_inst.target == NULL)
                 {
                     debug("Error: pc->cjmp_inst->target is null.\n");
-                    exit(1);
+                    Exit(1);
                 }
                 op1 = mem[pc->cjmp_inst.opernd1_index];
                 op2 = mem[pc->cjmp_inst.opernd2_index];
@@ -122,22 +120,62 @@ void execute_program(struct InstructionNode * program)
                 if (pc->jmp_inst.target == NULL)
                 {
                     debug("Error: pc->jmp_inst->target is null.\n");
-                    exit(1);
+                    Exit(1);
                 }
                 pc = pc->jmp_inst.target;
                 break;
             default:
                 debug("Error: invalid value for pc->type (%d).\n", pc->type);
-                exit(1);
+                Exit(1);
                 break;
         }
     }
 }
 
-int main()
+// Options:
+//   --stream     scan tokens on demand instead of tokenizing the whole input
+//                before parsing starts
+//   --parallel   tokenize large inputs on several threads
+//   --pipeline   scan tokens on a separate thread while parsing
+//   --batch      run every program of a batch (see batch.h)
+//   --jobs N     run a batch N programs at a time, one per core if N is 0
+//                (implies --batch)
+
+static void compile_and_run(ostream& out)
 {
+    Context context(out);
     struct InstructionNode * program;
-    program = parse_generate_intermediate_representation();
-    execute_program(program);
+    program = parse_generate_intermediate_representation(context);
+    execute_program(program, context);
+}
+
+int main(int argc, char* argv[])
+{
+    bool batch = false;
+    int jobs = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stream") == 0) {
+            LexicalAnalyzer::SetMode(STREAMING);
+        } else if (strcmp(argv[i], "--parallel") == 0) {
+            LexicalAnalyzer::SetMode(PARALLEL);
+        } else if (strcmp(argv[i], "--pipeline") == 0) {
+            LexicalAnalyzer::SetMode(PIPELINED);
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            batch = true;
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            batch = true;
+            jobs = atoi(argv[++i]);
+        } else {
+            printf("Error: unrecognized option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (batch) {
+        RunBatch(compile_and_run, jobs);
+        return 0;
+    }
+    compile_and_run(cout);
     return 0;
 }
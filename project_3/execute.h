@@ -6,14 +6,34 @@
 #ifndef _COMPILER_H_
 #define _COMPILER_H_
 
+#include <memory>
+#include <ostream>
 #include <string>
 #include <vector>
 
-extern int mem[1000];
-extern int next_available;
+struct InstructionNode;
 
-extern std::vector<int> inputs;
-extern int next_input;
+// Everything one program reads and writes while it is compiled and run.
+// Every compilation has a context of its own, so several programs can be
+// compiled and run on different threads at the same time.
+struct Context
+{
+    int mem[1000];
+    int next_available;
+
+    std::vector<int> inputs;
+    int next_input;
+
+    std::ostream& out;      // the program's output
+
+    // The instructions of the program, freed with the context
+    std::vector<std::unique_ptr<InstructionNode> > instructions;
+
+    explicit Context(std::ostream& out)
+        : mem(), next_available(0), next_input(0), out(out)
+    {
+    }
+};
 
 enum ArithmeticOperatorType {
     OPERATOR_NONE = 123,
@@ -89,7 +109,9 @@ void debug(const char* format, ...);
 //---------------------------------------------------------
 // You should write the following function:
 
-struct InstructionNode * parse_generate_intermediate_representation();
+struct InstructionNode * parse_generate_intermediate_representation(Context&);
+
+void execute_program(struct InstructionNode * program, Context&);
 
 /*
   NOTE:
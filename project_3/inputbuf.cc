@@ -8,38 +8,138 @@
 #include <vector>
 #include <string>
 #include <cstdio>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "inputbuf.h"
 
 using namespace std;
 
+InputBuffer::InputBuffer()
+    : data(source), size(source_size), pos(0), mapping(NULL),
+      mapping_size(0), loaded(source != NULL), eof(false)
+{
+}
+
+InputBuffer::~InputBuffer()
+{
+    if (mapping != NULL)
+        munmap(mapping, mapping_size);
+}
+
+thread_local const char* InputBuffer::source = NULL;
+thread_local size_t InputBuffer::source_size = 0;
+
+void InputBuffer::SetSource(const char* data, size_t size)
+{
+    source = data;
+    source_size = size;
+}
+
+// Standard input is mapped as a whole when it is a regular file, starting at
+// the current file offset. Pipes and terminals are read until end of file.
+void InputBuffer::Load()
+{
+    loaded = true;
+
+    struct stat st;
+    off_t offset = lseek(STDIN_FILENO, 0, SEEK_CUR);
+    if (fstat(STDIN_FILENO, &st) == 0 && S_ISREG(st.st_mode) &&
+        offset >= 0 && st.st_size > offset) {
+        void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+                       STDIN_FILENO, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, st.st_size, MADV_SEQUENTIAL);
+            mapping = p;
+            mapping_size = st.st_size;
+            data = (const char*) p + offset;
+            size = st.st_size - offset;
+            return;
+        }
+    }
+
+    char chunk[65536];
+    ssize_t n;
+    while ((n = read(STDIN_FILENO, chunk, sizeof(chunk))) > 0)
+        block.insert(block.end(), chunk, chunk + n);
+    data = block.empty() ? NULL : &block[0];
+    size = block.size();
+}
+
 bool InputBuffer::EndOfInput()
 {
     if (!input_buffer.empty())
         return false;
     else
-        return cin.eof();
+        return eof && pos >= size;
 }
 
 char InputBuffer::UngetChar(char c)
 {
-    if (c != EOF)
-        input_buffer.push_back(c);;
+    if (c != EOF) {
+        if (input_buffer.empty() && pos > 0 && data[pos-1] == c)
+            pos--;
+        else
+            input_buffer.push_back(c);
+    }
     return c;
 }
 
+const char* InputBuffer::Position()
+{
+    if (!loaded)
+        Load();
+    return data + pos;
+}
+
+const char* InputBuffer::End()
+{
+    if (!loaded)
+        Load();
+    return data + size;
+}
+
+void InputBuffer::Seek(const char* p)
+{
+    pos = p - data;
+}
+
+void InputBuffer::Attach(const char* data, size_t size)
+{
+    this->data = data;
+    this->size = size;
+    pos = 0;
+    loaded = true;
+}
+
+// Like cin.get(), reading past the end leaves c unchanged and sets the end
+// of file flag reported by EndOfInput()
 void InputBuffer::GetChar(char& c)
 {
+    if (!loaded)
+        Load();
     if (!input_buffer.empty()) {
         c = input_buffer.back();
         input_buffer.pop_back();
+    } else if (pos < size) {
+        c = data[pos++];
     } else {
-        cin.get(c);
+        eof = true;
     }
 }
 
 string InputBuffer::UngetString(string s)
 {
+    if (s.empty())
+        return s;
+    if (input_buffer.empty() && pos >= s.size() &&
+        memcmp(data + pos - s.size(), s.data(), s.size()) == 0) {
+        pos -= s.size();
+        return s;
+    }
     for (int i = 0; i < s.size(); i++)
         input_buffer.push_back(s[s.size()-i-1]);
     return s;
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Keyword lookup with a perfect hash computed at compile time.
+ */
+#ifndef __KEYWORD__H__
+#define __KEYWORD__H__
+
+#include <cstring>
+
+// Keyword i has token type i + 1. Only the first KEYWORDS_COUNT keywords are
+// recognized; ARRAY is scanned as an ID.
+#define KEYWORDS_COUNT 9
+
+static constexpr const char* keyword[] = { "VAR", "FOR", "IF", "WHILE",
+    "SWITCH", "CASE", "DEFAULT", "input", "output", "ARRAY" };
+
+// ------- perfect hash -------------------
+//
+// The slot of an identifier depends only on its length and its first and
+// last characters. keyword_slot[] is filled by the compiler, and the
+// static_assert below stops the build if two keywords land in the same slot,
+// so a lookup costs one table read and at most one memcmp().
+
+#define KEYWORD_SLOTS 32
+
+static constexpr int KeywordHash(int length, char first, char last)
+{
+    return (length * 9 + (unsigned char) first + (unsigned char) last) %
+           KEYWORD_SLOTS;
+}
+
+static constexpr int KeywordLength(const char* s)
+{
+    return *s == '\0' ? 0 : 1 + KeywordLength(s + 1);
+}
+
+static constexpr int KeywordSlot(int i)
+{
+    return KeywordHash(KeywordLength(keyword[i]), keyword[i][0],
+                       keyword[i][KeywordLength(keyword[i]) - 1]);
+}
+
+// Index of the keyword, starting from i, that occupies slot h or -1
+static constexpr int KeywordInSlot(int h, int i)
+{
+    return i == KEYWORDS_COUNT ? -1 :
+           KeywordSlot(i) == h ? i : KeywordInSlot(h, i + 1);
+}
+
+static constexpr bool KeywordsCollide(int i, int j)
+{
+    return i == KEYWORDS_COUNT ? false :
+           j == KEYWORDS_COUNT ? KeywordsCollide(i + 1, i + 2) :
+           KeywordSlot(i) == KeywordSlot(j) || KeywordsCollide(i, j + 1);
+}
+
+static_assert(!KeywordsCollide(0, 1), "two keywords share a hash slot");
+
+struct KeywordEntry {
+    signed char index;
+    unsigned char length;
+};
+
+#define KEYWORD_ENTRY(h) { (signed char) KeywordInSlot(h, 0), \
+    (unsigned char) (KeywordInSlot(h, 0) == -1 ? 0 : \
+                     KeywordLength(keyword[KeywordInSlot(h, 0)])) }
+#define KEYWORD_ENTRY4(h) KEYWORD_ENTRY(h), KEYWORD_ENTRY(h + 1), \
+    KEYWORD_ENTRY(h + 2), KEYWORD_ENTRY(h + 3)
+#define KEYWORD_ENTRY16(h) KEYWORD_ENTRY4(h), KEYWORD_ENTRY4(h + 4), \
+    KEYWORD_ENTRY4(h + 8), KEYWORD_ENTRY4(h + 12)
+
+static constexpr KeywordEntry keyword_slot[KEYWORD_SLOTS] = {
+    KEYWORD_ENTRY16(0), KEYWORD_ENTRY16(16)
+};
+
+#undef KEYWORD_ENTRY16
+#undef KEYWORD_ENTRY4
+#undef KEYWORD_ENTRY
+
+// Returns the index of the keyword s[0..length) or -1. length must be at
+// least 1.
+static inline int KeywordLookup(const char* s, int length)
+{
+    const KeywordEntry& e = keyword_slot[KeywordHash(length, s[0],
+                                                     s[length - 1])];
+    if (e.index != -1 && e.length == length &&
+        memcmp(s, keyword[e.index], length) == 0)
+        return e.index;
+    return -1;
+}
+
+#endif  //__KEYWORD__H__
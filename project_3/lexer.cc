@@ -8,9 +8,16 @@
 #include <vector>
 #include <string>
 #include <cctype>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 #include "lexer.h"
+#include "batch.h"
 #include "inputbuf.h"
+#include "scanner.h"
+#include "keyword.h"
 
 using namespace std;
 
@@ -23,24 +30,119 @@ string reserved[] = { "END_OF_FILE",
     "NUM", "ID", "ERROR"
 };
 
-#define KEYWORDS_COUNT 9
-
 void Token::Print()
 {
-    cout << "{" << this->lexeme << " , "
-         << reserved[(int) this->token_type] << " , "
+    cout << "{";
+    cout.write(this->text, this->length);
+    cout << " , " << reserved[(int) this->token_type] << " , "
          << this->line_no << "}\n";
 }
 
+bool Token::SameLexeme(const Token& other) const
+{
+    return length == other.length && memcmp(text, other.text, length) == 0;
+}
+
+LexerMode LexicalAnalyzer::default_mode = PRETOKENIZE;
+
+// Selects the mode of the lexers constructed afterwards
+void LexicalAnalyzer::SetMode(LexerMode mode)
+{
+    default_mode = mode;
+}
+
+// In STREAMING mode nothing is read until the first GetToken() or peek()
 LexicalAnalyzer::LexicalAnalyzer()
 {
     this->line_no = 1;
-    tmp.lexeme = "";
     tmp.line_no = 1;
     tmp.token_type = ERROR;
+    error_out = &cout;
+    mode = default_mode;
+    intern = true;
+    index = 0;
+    scanned = 0;
+    scanned_all = false;
 
-    Token token = GetTokenMain();
+    if (mode == STREAMING)
+        return;
+    if (mode == PIPELINED) {
+        pipe.resize(PIPE_SIZE);
+        producer = thread(&LexicalAnalyzer::Produce, this);
+        return;
+    }
+    if (mode == PARALLEL)
+        TokenizeParallel();
+    else
+        Tokenize();
+}
+
+LexicalAnalyzer::~LexicalAnalyzer()
+{
+    if (producer.joinable()) {
+        stopping = true;
+        producer.join();
+    }
+}
+
+// Runs on the producer thread in PIPELINED mode. The producer is the only
+// writer of "produced" and the consumer the only writer of "released". A
+// slot is only overwritten after the consumer has released it, and a new
+// token becomes visible to the consumer with the store to "produced".
+void LexicalAnalyzer::Produce()
+{
+    int n = 0;
+    while (!stopping.load(memory_order_relaxed)) {
+        Token token = GetTokenMain();
+        if (token.token_type == END_OF_FILE)
+            break;
+        while (n - released.load(memory_order_acquire) >= PIPE_SIZE) {
+            if (stopping.load(memory_order_relaxed))
+                return;
+            this_thread::yield();
+        }
+        pipe[n % PIPE_SIZE] = token;
+        produced.store(++n, memory_order_release);
+    }
+    produced_all.store(true, memory_order_release);
+}
+
+// Waits until the token howFar positions ahead of index is in the pipe or
+// the producer has reached the end of the input, and returns the number of
+// tokens produced so far. Once produced_all is set, line_no is final.
+int LexicalAnalyzer::Wait(int howFar)
+{
+    int n = produced.load(memory_order_acquire);
+    while (n < index + howFar) {
+        if (produced_all.load(memory_order_acquire))
+            return produced.load(memory_order_acquire);
+        this_thread::yield();
+        n = produced.load(memory_order_acquire);
+    }
+    return n;
+}
+
+// Scans [begin, end) of an input that is already in memory, numbering lines
+// from 1. Used by TokenizeParallel() for one piece of the input.
+LexicalAnalyzer::LexicalAnalyzer(const char* begin, const char* end)
+{
+    this->line_no = 1;
+    tmp.line_no = 1;
+    tmp.token_type = ERROR;
+    error_out = &cout;
+    mode = PRETOKENIZE;
+    intern = false;     // TokenizeParallel() interns in input order
     index = 0;
+    scanned = 0;
+    scanned_all = false;
+
+    input.Attach(begin, end - begin);
+    Tokenize();
+}
+
+void LexicalAnalyzer::Tokenize()
+{
+    Token token = GetTokenMain();
 
     while (token.token_type != END_OF_FILE)
     {
@@ -50,108 +152,174 @@ LexicalAnalyzer::LexicalAnalyzer()
     // pushes END_OF_FILE is not pushed on the token list
 }
 
-bool LexicalAnalyzer::SkipSpace()
+// No token contains a newline or a ';', so the input can be cut right after
+// either one and the pieces scanned independently. Each piece numbers its
+// lines from 1; the tokens are shifted by the number of newlines in the
+// pieces before them when they are appended to tokenList, which makes the
+// result identical to Tokenize().
+void LexicalAnalyzer::TokenizeParallel()
 {
-    char c;
-    bool space_encountered = false;
+    const char* begin = input.Position();
+    const char* end = input.End();
+    int threads = max(1, (int) thread::hardware_concurrency());
+    size_t chunk = max((size_t) PARALLEL_CHUNK,
+                       (size_t) (end - begin) / (threads * 4) + 1);
 
-    input.GetChar(c);
-    line_no += (c == '\n');
+    vector<const char*> cuts(1, begin);
+    const char* p = begin;
+    while ((size_t) (end - p) > chunk) {
+        p += chunk;
+        while (p < end && *p != '\n' && *p != ';')
+            p++;
+        if (p < end)
+            cuts.push_back(++p);
+    }
+    cuts.push_back(end);
 
-    while (!input.EndOfInput() && isspace(c)) {
-        space_encountered = true;
-        input.GetChar(c);
-        line_no += (c == '\n');
+    int pieces = cuts.size() - 1;
+    if (pieces == 1) {
+        Tokenize();
+        return;
     }
 
-    if (!input.EndOfInput()) {
-        input.UngetChar(c);
+    vector< vector<Token> > tokens(pieces);
+    vector<int> newlines(pieces);
+    atomic<int> next(0);
+    auto work = [&]() {
+        for (int k = next++; k < pieces; k = next++) {
+            LexicalAnalyzer piece(cuts[k], cuts[k + 1]);
+            tokens[k].swap(piece.tokenList);
+            newlines[k] = piece.line_no - 1;
+        }
+    };
+    vector<thread> pool;
+    for (int i = 1; i < min(threads, pieces); i++)
+        pool.push_back(thread(work));
+    work();
+    for (size_t i = 0; i < pool.size(); i++)
+        pool[i].join();
+
+    size_t total = 0;
+    for (int k = 0; k < pieces; k++)
+        total += tokens[k].size();
+    tokenList.reserve(total);
+    for (int k = 0; k < pieces; k++) {
+        for (size_t i = 0; i < tokens[k].size(); i++) {
+            tokens[k][i].line_no += line_no - 1;
+            if (tokens[k][i].token_type == ID)
+                tokens[k][i].symbol = symbols.Intern(tokens[k][i].text,
+                                                     tokens[k][i].length);
+            tokenList.push_back(tokens[k][i]);
+        }
+        line_no += newlines[k];
     }
-    return space_encountered;
+    input.Seek(end);
 }
 
-int LexicalAnalyzer::FindKeywordIndex(string s)
+bool LexicalAnalyzer::SkipSpace()
 {
-    string keyword[] = { "VAR", "FOR", "IF", "WHILE", "SWITCH", "CASE", "DEFAULT", "input", "output", "ARRAY" };
-    for (int i = 0; i < KEYWORDS_COUNT; i++) {
-        if (s == keyword[i]) {
-            return i + 1;
-        }
-    }
-    return -1;
+    const char* p = input.Position();
+    const char* q = ScanRun(p, input.End(), CC_SPACE, &line_no);
+
+    input.Seek(q);
+    return q != p;
 }
 
+int LexicalAnalyzer::FindKeywordIndex(const char* s, int length)
+{
+    int i = KeywordLookup(s, length);
+    return i == -1 ? -1 : i + 1;
+}
+
+// ScanNumber() is called with the cursor on a digit. As before, a leading 0
+// is a number by itself.
 Token LexicalAnalyzer::ScanNumber()
 {
-    char c;
+    const char* p = input.Position();
+    const char* q = p + 1;
 
-    input.GetChar(c);
-    if (isdigit(c)) {
-        if (c == '0') {
-            tmp.lexeme = "0";
-        } else {
-            tmp.lexeme = "";
-            while (!input.EndOfInput() && isdigit(c)) {
-                tmp.lexeme += c;
-                input.GetChar(c);
-            }
-            if (!input.EndOfInput()) {
-                input.UngetChar(c);
-            }
-        }
-        tmp.token_type = NUM;
-        tmp.line_no = line_no;
-        return tmp;
-    } else {
-        if (!input.EndOfInput()) {
-            input.UngetChar(c);
-        }
-        tmp.lexeme = "";
-        tmp.token_type = ERROR;
-        tmp.line_no = line_no;
-        return tmp;
-    }
+    if (*p != '0')
+        q = ScanRun(q, input.End(), CC_DIGIT, NULL);
+
+    unsigned value = 0;
+    for (const char* d = p; d < q; d++)
+        value = value * 10 + (*d - '0');
+
+    input.Seek(q);
+    tmp.text = p;
+    tmp.length = q - p;
+    tmp.value = (int) value;
+    tmp.token_type = NUM;
+    tmp.line_no = line_no;
+    return tmp;
 }
 
+// ScanIdOrKeyword() is called with the cursor on a letter
 Token LexicalAnalyzer::ScanIdOrKeyword()
 {
-    char c;
-    input.GetChar(c);
+    const char* p = input.Position();
+    const char* q = ScanRun(p + 1, input.End(), CC_ALNUM, NULL);
 
-    if (isalpha(c)) {
-        tmp.lexeme = "";
-        while (!input.EndOfInput() && isalnum(c)) {
-            tmp.lexeme += c;
-            input.GetChar(c);
-        }
-        if (!input.EndOfInput()) {
-            input.UngetChar(c);
-        }
-        tmp.line_no = line_no;
-        int keywordIndex = FindKeywordIndex(tmp.lexeme);
-        if (keywordIndex != -1)
-            tmp.token_type = (TokenType) keywordIndex;
-        else
-            tmp.token_type = ID;
+    input.Seek(q);
+    tmp.text = p;
+    tmp.length = q - p;
+    tmp.line_no = line_no;
+    int keywordIndex = FindKeywordIndex(tmp.text, tmp.length);
+    if (keywordIndex != -1) {
+        tmp.token_type = (TokenType) keywordIndex;
     } else {
-        if (!input.EndOfInput()) {
-            input.UngetChar(c);
-        }
-        tmp.lexeme = "";
-        tmp.token_type = ERROR;
+        tmp.token_type = ID;
+        if (intern)
+            tmp.symbol = symbols.Intern(tmp.text, tmp.length);
     }
     return tmp;
 }
 
+// Fill() scans tokens into the ring until the token "howFar" positions
+// ahead of index is available or the input is exhausted
+void LexicalAnalyzer::Fill(int howFar)
+{
+    while (!scanned_all && scanned < index + howFar) {
+        Token token = GetTokenMain();
+        if (token.token_type == END_OF_FILE) {
+            scanned_all = true;
+        } else {
+            ring[scanned % RING_SIZE] = token;
+            scanned++;
+        }
+    }
+}
+
+const Token& LexicalAnalyzer::EndOfFileToken()
+{
+    end_of_file.length = 0;
+    end_of_file.line_no = line_no;
+    end_of_file.token_type = END_OF_FILE;
+    return end_of_file;
+}
+
 // GetToken() accesses tokens from the tokenList that is populated when a 
-// lexer object is instantiated
+// lexer object is instantiated, or from the ring in STREAMING mode
 Token LexicalAnalyzer::GetToken()
 {
+    if (mode == STREAMING) {
+        Fill(1);
+        if (index == scanned)
+            return EndOfFileToken();
+        return ring[index++ % RING_SIZE];
+    }
+
+    if (mode == PIPELINED) {
+        if (Wait(1) == index)
+            return EndOfFileToken();
+        Token token = pipe[index++ % PIPE_SIZE];
+        released.store(index, memory_order_release);
+        return token;
+    }
+
     Token token;
     if (index == tokenList.size()){       // return end of file if
-        token.lexeme = "";                // index is too large
-        token.line_no = line_no;
-        token.token_type = END_OF_FILE;
+        token = EndOfFileToken();         // index is too large
     }
     else{
         token = tokenList[index];
@@ -160,37 +328,60 @@ Token LexicalAnalyzer::GetToken()
     return token;
 }
 
-// peek requires that the argument "howFar" be positive.
-Token LexicalAnalyzer::peek(int howFar)
+// peek requires that the argument "howFar" be positive. The returned
+// reference is valid until the next call to GetToken().
+const Token& LexicalAnalyzer::peek(int howFar)
 {
     if (howFar <= 0) {      // peeking backward or in place is not allowed
-        cout << "LexicalAnalyzer:peek:Error: non positive argument\n";
-        exit(-1);
+        *error_out << "LexicalAnalyzer:peek:Error: non positive argument\n";
+        Exit(-1);
+    }
+
+    if (mode == STREAMING) {
+        if (howFar >= RING_SIZE) { // only RING_SIZE - 1 tokens are kept ahead
+            *error_out
+                << "LexicalAnalyzer:peek:Error: argument exceeds lookahead\n";
+            Exit(-1);
+        }
+        Fill(howFar);
+        if (index + howFar > scanned)
+            return EndOfFileToken();
+        return ring[(index + howFar - 1) % RING_SIZE];
+    }
+
+    if (mode == PIPELINED) {
+        if (howFar > PIPE_SIZE) {
+            *error_out
+                << "LexicalAnalyzer:peek:Error: argument exceeds lookahead\n";
+            Exit(-1);
+        }
+        if (Wait(howFar) < index + howFar)
+            return EndOfFileToken();
+        return pipe[(index + howFar - 1) % PIPE_SIZE];
     }
 
     int peekIndex = index + howFar - 1;
     if (peekIndex > (int)(tokenList.size())-1) { // if peeking too far
-        Token token;                        // return END_OF_FILE
-        token.lexeme = "";
-        token.line_no = line_no;
-        token.token_type = END_OF_FILE;
-        return token;
+        return EndOfFileToken();            // return END_OF_FILE
     } else
         return tokenList[peekIndex];
 }
 
 Token LexicalAnalyzer::GetTokenMain()
 {
-    char c;
-
     SkipSpace();
-    tmp.lexeme = "";
+    tmp.length = 0;
+    tmp.value = 0;
+    tmp.symbol = -1;
     tmp.line_no = line_no;
     tmp.token_type = END_OF_FILE;
-    if (!input.EndOfInput())
-        input.GetChar(c);
-    else
+
+    const char* p = input.Position();
+    const char* end = input.End();
+    if (p == end)
         return tmp;
+    char c = *p;
+    input.Seek(p + 1);
 
     switch (c) {
         case '+':   tmp.token_type = PLUS;      return tmp;
@@ -209,26 +400,21 @@ Token LexicalAnalyzer::GetTokenMain()
         case '}':   tmp.token_type = RBRACE;    return tmp;
         case '>':   tmp.token_type = GREATER;   return tmp;
         case '<':
-            input.GetChar(c);
-            if (c == '>') {
+            if (p + 1 < end && p[1] == '>') {
+                input.Seek(p + 2);
                 tmp.token_type = NOTEQUAL;
             } else {
-                if (!input.EndOfInput()) {
-                    input.UngetChar(c);
-                }
                 tmp.token_type = LESS;
             }
             return tmp;
         default:
-            if (isdigit(c)) {
-                input.UngetChar(c);
+            if (IsClass(c, CC_DIGIT)) {
+                input.Seek(p);
                 return ScanNumber();
-            } else if (isalpha(c)) {
-                input.UngetChar(c);
+            } else if (IsClass(c, CC_ALPHA)) {
+                input.Seek(p);
                 return ScanIdOrKeyword();
-            } else if (input.EndOfInput())
-                tmp.token_type = END_OF_FILE;
-            else
+            } else
                 tmp.token_type = ERROR;
 
             return tmp;
@@ -11,7 +11,6 @@
 #include <algorithm>
 #include <cstdlib>
 #include <iostream>
-#include <map>
 #include <queue>
 #include <stack>
 #include <string>
@@ -20,14 +19,21 @@
 #include <utility>
 #include <vector>
 
+#include "batch.h"    // NOLINT
 #include "execute.h"  // NOLINT
 #include "lexer.h"    // NOLINT
 
-std::map<std::string, int> var_location_table;
+// Memory address of a variable. A variable that was never declared is at
+// address 0.
+int& Parser::var_location(const Token& id_token) {
+  if (id_token.symbol >= static_cast<int>(var_location_table.size()))
+    var_location_table.resize(id_token.symbol + 1, 0);
+  return var_location_table[id_token.symbol];
+}
 
 void Parser::syntax_error() {
-  std::cout << "SNYATX EORRR !!!";
-  exit(1);
+  context.out << "SNYATX EORRR !!!";
+  Exit(1);
 }
 
 Token Parser::expect(TokenType expected_type) {
@@ -38,7 +44,17 @@ Token Parser::expect(TokenType expected_type) {
   return t;
 }
 
-Parser::Parser() {}
+// A parser compiles one program into the memory and inputs of its context
+Parser::Parser(Context& context) : context(context) {
+  lexer.SetErrorOutput(context.out);
+}
+
+// Instructions belong to the context, so a batch frees every program's
+// instructions when it is done with the program
+struct InstructionNode* Parser::new_instruction() {
+  context.instructions.emplace_back(new InstructionNode);
+  return context.instructions.back().get();
+}
 
 struct InstructionNode* Parser::parse_program() {
   struct InstructionNode* program;
@@ -49,14 +65,12 @@ struct InstructionNode* Parser::parse_program() {
     syntax_error();
   }
 
-  Token token2 = lexer.peek(1);
   if (token.token_type == ID) {
     program = parse_body();
   } else {
     syntax_error();
   }
 
-  Token token3 = lexer.peek(1);
   if (token.token_type == ID) {
     parse_inputs();
   } else {
@@ -70,21 +84,19 @@ struct InstructionNode* Parser::parse_program() {
  * Parsing of input variables:
  *
  * The input variables and their respective memory locations are stored as a
- * table - var_location_table, which contains the address of each of the
- * variable_int_map_node structure. This contains two values which are the index
- * number and the variable name associated with that index.
+ * table - var_location_table, which holds the address of each variable at the
+ * index of the symbol the lexer interned its name as.
  */
 void Parser::parse_variable_section() {
-  Token t = lexer.peek(1);
   parse_id_list();
   expect(SEMICOLON);
 }
 
 void Parser::parse_id_list() {
   Token id_token = expect(ID);
-  var_location_table[id_token.lexeme] = next_available;
-  mem[next_available] = 0;
-  next_available++;
+  var_location(id_token) = context.next_available;
+  context.mem[context.next_available] = 0;
+  context.next_available++;
 
   Token token;
   token = lexer.peek(1);
@@ -107,7 +119,7 @@ void Parser::parse_inputs() { parse_num_list(); }
 
 void Parser::parse_num_list() {
   Token token = expect(NUM);
-  inputs.push_back(std::stoi(token.lexeme));
+  context.inputs.push_back(token.value);
 
   Token next = lexer.peek(1);
 
@@ -158,7 +170,7 @@ struct InstructionNode* Parser::parse_statement_list() {
 
 struct InstructionNode* Parser::parse_statement() {
   struct InstructionNode* instruction = nullptr;
-  struct InstructionNode* init = new InstructionNode;
+  struct InstructionNode* init = new_instruction();
 
   init->type = NOOP;
   init->next = nullptr;
@@ -211,34 +223,33 @@ struct InstructionNode* Parser::parse_statement() {
 }
 
 struct InstructionNode* Parser::parse_input_statement() {
-  struct InstructionNode* input_instruction = new InstructionNode;
+  struct InstructionNode* input_instruction = new_instruction();
   expect(INPUT);
   input_instruction->type = IN;
   Token t = expect(ID);
-  input_instruction->input_inst.var_index = var_location_table[t.lexeme];
+  input_instruction->input_inst.var_index = var_location(t);
   input_instruction->next = nullptr;
   expect(SEMICOLON);
   return input_instruction;
 }
 
 struct InstructionNode* Parser::parse_output_statement() {
-  struct InstructionNode* output_instruction = new InstructionNode;
+  struct InstructionNode* output_instruction = new_instruction();
   expect(OUTPUT);
   output_instruction->type = OUT;
   Token t = expect(ID);
-  output_instruction->output_inst.var_index = var_location_table[t.lexeme];
+  output_instruction->output_inst.var_index = var_location(t);
   output_instruction->next = nullptr;
   expect(SEMICOLON);
   return output_instruction;
 }
 
 struct InstructionNode* Parser::parse_assignment_statement() {
-  struct InstructionNode* assign_instruction = new InstructionNode;
+  struct InstructionNode* assign_instruction = new_instruction();
   assign_instruction->type = ASSIGN;
 
   Token token = expect(ID);
-  assign_instruction->assign_inst.left_hand_side_index =
-      var_location_table[token.lexeme];
+  assign_instruction->assign_inst.left_hand_side_index = var_location(token);
 
   expect(EQUAL);
 
@@ -269,7 +280,7 @@ struct InstructionNode* Parser::parse_assignment_statement() {
 }
 
 struct InstructionNode* Parser::parse_expression() {
-  struct InstructionNode* get_operation_type = new InstructionNode;
+  struct InstructionNode* get_operation_type = new_instruction();
   get_operation_type->assign_inst.opernd1_index = parse_primary();
 
   switch (parse_operation()) {
@@ -298,10 +309,10 @@ int Parser::parse_primary() {
   Token token = lexer.GetToken();
   if (token.token_type == ID || token.token_type == NUM) {
     if (token.token_type == ID) {
-      index = var_location_table[token.lexeme];
+      index = var_location(token);
     } else {
-      index = next_available;
-      mem[next_available++] = stoi(token.lexeme);
+      index = context.next_available;
+      context.mem[context.next_available++] = token.value;
     }
   } else {
     syntax_error();
@@ -320,7 +331,7 @@ TokenType Parser::parse_operation() {
 }
 
 struct InstructionNode* Parser::parse_if_statement() {
-  struct InstructionNode* if_instruction = new InstructionNode;
+  struct InstructionNode* if_instruction = new_instruction();
   expect(IF);
 
   if_instruction->type = CJMP;
@@ -339,7 +350,7 @@ struct InstructionNode* Parser::parse_if_statement() {
     syntax_error();
   }
 
-  struct InstructionNode* no_operation_node = new InstructionNode;
+  struct InstructionNode* no_operation_node = new_instruction();
   no_operation_node->type = NOOP;
   no_operation_node->next = nullptr;
 
@@ -355,7 +366,7 @@ struct InstructionNode* Parser::parse_if_statement() {
 }
 
 struct InstructionNode* Parser::parse_condition() {
-  struct InstructionNode* get_condition_node = new InstructionNode;
+  struct InstructionNode* get_condition_node = new_instruction();
 
   Token token_1 = lexer.peek(1);
   if (token_1.token_type == ID || token_1.token_type == NUM) {
@@ -404,7 +415,7 @@ TokenType Parser::parse_relation_operation() {
 }
 
 struct InstructionNode* Parser::parse_while_statement() {
-  struct InstructionNode* while_instruction = new InstructionNode;
+  struct InstructionNode* while_instruction = new_instruction();
   expect(WHILE);
   while_instruction->type = CJMP;
   struct InstructionNode* nagisa = parse_condition();
@@ -420,11 +431,11 @@ struct InstructionNode* Parser::parse_while_statement() {
     syntax_error();
   }
 
-  struct InstructionNode* jump_node = new InstructionNode;
+  struct InstructionNode* jump_node = new_instruction();
   jump_node->type = JMP;
   jump_node->jmp_inst.target = while_instruction;
 
-  struct InstructionNode* no_operation_node = new InstructionNode;
+  struct InstructionNode* no_operation_node = new_instruction();
   no_operation_node->type = NOOP;
   no_operation_node->next = nullptr;
 
@@ -441,11 +452,11 @@ struct InstructionNode* Parser::parse_while_statement() {
 
 struct InstructionNode* Parser::parse_switch_statement(
     struct InstructionNode* init) {
-  struct InstructionNode* switch_instruction = new InstructionNode;
+  struct InstructionNode* switch_instruction = new_instruction();
   expect(SWITCH);
 
   Token token_1 = expect(ID);
-  int switch_operation = var_location_table[token_1.lexeme];
+  int switch_operation = var_location(token_1);
   expect(LBRACE);
 
   Token token_2 = lexer.peek(1);
@@ -476,14 +487,14 @@ struct InstructionNode* Parser::parse_switch_statement(
 
 struct InstructionNode* Parser::parse_case_list(int operation,
                                                 struct InstructionNode* init) {
-  struct InstructionNode* case_node = new InstructionNode;
+  struct InstructionNode* case_node = new_instruction();
   struct InstructionNode* case_list_node = nullptr;
 
   Token token_1 = lexer.peek(1);
   if (token_1.token_type == CASE) {
     case_node = parse_case(operation);
 
-    struct InstructionNode* jump_node = new InstructionNode;
+    struct InstructionNode* jump_node = new_instruction();
     jump_node->type = JMP;
     jump_node->jmp_inst.target = init;
     struct InstructionNode* get_last_node = case_node->cjmp_inst.target;
@@ -510,15 +521,15 @@ struct InstructionNode* Parser::parse_case_list(int operation,
 }
 
 struct InstructionNode* Parser::parse_case(int op) {
-  struct InstructionNode* case_instruction = new InstructionNode;
+  struct InstructionNode* case_instruction = new_instruction();
   expect(CASE);
   case_instruction->type = CJMP;
   case_instruction->cjmp_inst.opernd1_index = op;
   case_instruction->cjmp_inst.condition_op = CONDITION_NOTEQUAL;
   Token token_1 = expect(NUM);
 
-  int index = next_available;
-  mem[next_available++] = std::stoi(token_1.lexeme);
+  int index = context.next_available;
+  context.mem[context.next_available++] = token_1.value;
   case_instruction->cjmp_inst.opernd2_index = index;
 
   expect(COLON);
@@ -529,7 +540,7 @@ struct InstructionNode* Parser::parse_case(int op) {
     syntax_error();
   }
 
-  struct InstructionNode* no_operation = new InstructionNode;
+  struct InstructionNode* no_operation = new_instruction();
   no_operation->type = NOOP;
   no_operation->next = nullptr;
 
@@ -543,7 +554,7 @@ struct InstructionNode* Parser::parse_case(int op) {
 }
 
 struct InstructionNode* Parser::parse_default_case() {
-  struct InstructionNode* deafault_instruction = new InstructionNode;
+  struct InstructionNode* deafault_instruction = new_instruction();
   expect(DEFAULT);
   expect(COLON);
 
@@ -557,8 +568,8 @@ struct InstructionNode* Parser::parse_default_case() {
 }
 
 struct InstructionNode* Parser::parse_for_statement() {
-  struct InstructionNode* for_instruction = new InstructionNode;
-  struct InstructionNode* assignStmt = new InstructionNode;
+  struct InstructionNode* for_instruction = new_instruction();
+  struct InstructionNode* assignStmt = new_instruction();
   expect(FOR);
   expect(LPAREN);
 
@@ -570,7 +581,7 @@ struct InstructionNode* Parser::parse_for_statement() {
     syntax_error();
   }
 
-  auto* condition_instruction = new InstructionNode;
+  auto* condition_instruction = new_instruction();
   condition_instruction->type = CJMP;
   // condition
   struct InstructionNode* condition_node = parse_condition();
@@ -605,11 +616,11 @@ struct InstructionNode* Parser::parse_for_statement() {
   }
   increment_statement->next = assignStmt;
 
-  struct InstructionNode* jump_node = new InstructionNode;
+  struct InstructionNode* jump_node = new_instruction();
   jump_node->type = JMP;
   jump_node->jmp_inst.target = condition_instruction;
 
-  struct InstructionNode* no_operation = new InstructionNode;
+  struct InstructionNode* no_operation = new_instruction();
   no_operation->type = NOOP;
   no_operation->next = nullptr;
 
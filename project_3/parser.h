@@ -22,12 +22,17 @@ struct variable_int_map_node {
 
 class Parser {
  private:
+  Context& context;
   LexicalAnalyzer lexer;
+  // Memory address of each variable, indexed by the symbol of its name
+  std::vector<int> var_location_table;
   void syntax_error();
   Token expect(TokenType expected_type);
+  int& var_location(const Token& id_token);
+  struct InstructionNode* new_instruction();
 
  public:
-  Parser();
+  explicit Parser(Context& context);
   struct InstructionNode* parse_program();
   void parse_variable_section();
   void parse_id_list();
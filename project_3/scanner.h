@@ -0,0 +1,30 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Table-driven scanning core shared by GetTokenMain() and SkipSpace().
+ */
+#ifndef __SCANNER__H__
+#define __SCANNER__H__
+
+// ------- character classes -------------------
+
+#define CC_SPACE 1   // ' ', '\t', '\n', '\v', '\f', '\r' (isspace)
+#define CC_ALPHA 2   // 'A'-'Z', 'a'-'z' (isalpha)
+#define CC_DIGIT 4   // '0'-'9' (isdigit)
+#define CC_ALNUM (CC_ALPHA | CC_DIGIT)
+
+extern const unsigned char char_class[256];
+
+inline bool IsClass(char c, unsigned classes)
+{
+    return (char_class[(unsigned char) c] & classes) != 0;
+}
+
+// Returns the first position in [p, end) whose character is not in one of
+// "classes". Runs are classified 32 bytes at a time with AVX2 or 16 bytes at
+// a time with SSE2 when the compiler targets them. If newlines is not NULL
+// the number of '\n' characters in the run is added to it.
+const char* ScanRun(const char* p, const char* end, unsigned classes,
+                    int* newlines);
+
+#endif  //__SCANNER__H__
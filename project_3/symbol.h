@@ -0,0 +1,33 @@
+/*
+ * Copyright 2022 Kaustubh Harapanahalli
+ *
+ * Interning of identifiers.
+ */
+#ifndef __SYMBOL__H__
+#define __SYMBOL__H__
+
+#include <string>
+#include <vector>
+
+// Maps every distinct name to a symbol. Symbols are numbered densely from 0
+// in order of first appearance, so tables keyed by name can be vectors
+// indexed by symbol.
+class SymbolTable {
+  public:
+    SymbolTable();
+
+    // Returns the symbol of text[0..length), adding it if it is new
+    int Intern(const char* text, int length);
+
+    int size() const { return (int) names.size(); }
+    const std::string& name(int symbol) const { return names[symbol]; }
+
+  private:
+    void Grow();
+
+    std::vector<std::string> names;
+    std::vector<unsigned> hashes;   // hash of each name, for Grow()
+    std::vector<int> slots;         // open addressing, -1 marks a free slot
+};
+
+#endif  //__SYMBOL__H__